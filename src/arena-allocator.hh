@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace cursor {
+// An arena carves allocations out of large blocks and recycles freed
+// allocations through per size class free lists, so that many small buffers
+// can share a few large allocations. Allocations larger than a quarter of a
+// block bypass the arena. An arena is not thread safe and must outlive every
+// allocator that refers to it.
+class Arena {
+public:
+    static constexpr std::size_t default_block_size = 1 << 20;
+
+    explicit Arena(std::size_t block_size_ = default_block_size)
+        : block_size{std::max(block_size_, min_size_class_size * 4)} {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        for (auto block : blocks) {
+            ::operator delete(block);
+        }
+    }
+
+    void* allocate(std::size_t size) {
+        if (is_large(size)) {
+            return ::operator new(size);
+        }
+
+        const auto size_class = to_size_class(size);
+        if (size_class >= free_lists.size()) {
+            free_lists.resize(size_class + 1, nullptr);
+        }
+
+        auto& free_list = free_lists[size_class];
+        if (free_list != nullptr) {
+            auto allocation = free_list;
+            free_list = free_list->next;
+            return allocation;
+        }
+
+        const auto class_size = to_size_class_size(size_class);
+        if (blocks.empty() || ((block_position + class_size) > block_size)) {
+            blocks.push_back(static_cast<char*>(::operator new(block_size)));
+            block_position = 0;
+        }
+        auto allocation = blocks.back() + block_position;
+        block_position += class_size;
+        return allocation;
+    }
+
+    void deallocate(void* allocation, std::size_t size) {
+        if (is_large(size)) {
+            ::operator delete(allocation);
+            return;
+        }
+
+        auto& free_list = free_lists[to_size_class(size)];
+        free_list = new (allocation) FreeAllocation{free_list};
+    }
+
+private:
+    struct FreeAllocation {
+        FreeAllocation* next;
+    };
+
+    static constexpr std::size_t min_size_class_size = 16;
+
+    bool is_large(std::size_t size) const {
+        return size > (block_size / 4);
+    }
+
+    static std::size_t to_size_class(std::size_t size) {
+        std::size_t size_class = 0;
+        while (to_size_class_size(size_class) < size) {
+            size_class += 1;
+        }
+        return size_class;
+    }
+
+    static std::size_t to_size_class_size(std::size_t size_class) {
+        return min_size_class_size << size_class;
+    }
+
+    std::size_t block_size;
+    std::size_t block_position = 0;
+    std::vector<char*> blocks;
+    std::vector<FreeAllocation*> free_lists;
+};
+
+template<typename Element>
+class ArenaAllocator {
+public:
+    using value_type = Element;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    static_assert(alignof(Element) <= alignof(std::max_align_t), "Arena allocations are not over-aligned");
+
+    explicit ArenaAllocator(Arena& arena_) : arena{&arena_} {}
+
+    template<typename OtherElement>
+    ArenaAllocator(const ArenaAllocator<OtherElement>& other) : arena{other.arena} {}
+
+    Element* allocate(std::size_t count) {
+        return static_cast<Element*>(arena->allocate(count * sizeof(Element)));
+    }
+
+    void deallocate(Element* allocation, std::size_t count) {
+        arena->deallocate(allocation, count * sizeof(Element));
+    }
+
+    template<typename OtherElement>
+    bool operator==(const ArenaAllocator<OtherElement>& other) const { return arena == other.arena; }
+
+    template<typename OtherElement>
+    bool operator!=(const ArenaAllocator<OtherElement>& other) const { return arena != other.arena; }
+
+private:
+    template<typename OtherElement>
+    friend class ArenaAllocator;
+
+    Arena* arena;
+};
+
+}
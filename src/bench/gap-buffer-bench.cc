@@ -0,0 +1,676 @@
+#include "byte-search.hh"
+#include "chunked-gap-buffer.hh"
+#include "code-point-index.hh"
+#include "content-hash.hh"
+#include "gap-buffer.hh"
+#include "growth-policy.hh"
+#include "instrumentation.hh"
+#include "line-index.hh"
+#include "mark-set.hh"
+#include "parallel-algorithm.hh"
+#include "piece-table.hh"
+#include "range.hh"
+#include "segmented-algorithm.hh"
+#include "trigram-index.hh"
+#include "utf8.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace bench {
+namespace gap_buffer {
+namespace {
+
+constexpr std::int64_t min_buffer_size = 1 << 10;
+constexpr std::int64_t max_buffer_size = 1 << 30;
+constexpr int buffer_size_multiplier = 32;
+
+constexpr std::int64_t paste_size = 64 << 10;
+constexpr int line_size = 80;
+
+std::string make_text(std::int64_t size)
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> letter_distribution{ 'a', 'z' };
+    std::uniform_int_distribution<> word_size_distribution{ 1, 10 };
+    std::string text;
+    text.reserve(size);
+    auto word_size = word_size_distribution(random_engine);
+    auto column = 0;
+    while (static_cast<std::int64_t>(text.size()) < size) {
+        if (column == line_size) {
+            text.push_back('\n');
+            column = 0;
+        } else if (word_size == 0) {
+            text.push_back(' ');
+            word_size = word_size_distribution(random_engine);
+            column += 1;
+        } else {
+            text.push_back(static_cast<char>(letter_distribution(random_engine)));
+            word_size -= 1;
+            column += 1;
+        }
+    }
+    return text;
+}
+
+template <typename Container> Container make_container(const std::string& text)
+{
+    return Container(text.begin(), text.end());
+}
+
+template <typename GapBufferType> GapBufferType make_gap_buffer(const std::string& text)
+{
+    GapBufferType gap_buffer;
+    gap_buffer.append(make_crange(text));
+    return gap_buffer;
+}
+
+template <> GapBuffer<char> make_container(const std::string& text) { return make_gap_buffer<GapBuffer<char>>(text); }
+
+using OneAndAHalfGapBuffer = GapBuffer<char, std::allocator<char>, OneAndAHalfGrowthPolicy>;
+using GapProportionalGapBuffer = GapBuffer<char, std::allocator<char>, GapProportionalGrowthPolicy<1, 16>>;
+using InstrumentedGapBuffer = GapBuffer<char, std::allocator<char>, DoublingGrowthPolicy, CountingInstrumentation>;
+
+template <> OneAndAHalfGapBuffer make_container(const std::string& text)
+{
+    return make_gap_buffer<OneAndAHalfGapBuffer>(text);
+}
+
+template <> GapProportionalGapBuffer make_container(const std::string& text)
+{
+    return make_gap_buffer<GapProportionalGapBuffer>(text);
+}
+
+template <> InstrumentedGapBuffer make_container(const std::string& text)
+{
+    return make_gap_buffer<InstrumentedGapBuffer>(text);
+}
+
+using CharChunkedGapBuffer = ChunkedGapBuffer<char>;
+
+template <> CharChunkedGapBuffer make_container(const std::string& text)
+{
+    return make_gap_buffer<CharChunkedGapBuffer>(text);
+}
+
+using CharPieceTable = PieceTable<char>;
+
+template <> CharPieceTable make_container(const std::string& text)
+{
+    CharPieceTable piece_table;
+    piece_table.assign(make_crange(text));
+    return piece_table;
+}
+
+template <typename Container> std::int64_t size(const Container& container)
+{
+    return static_cast<std::int64_t>(container.size());
+}
+
+template <typename Container> void insert(Container& container, std::int64_t position, const std::string& text)
+{
+    container.insert(container.begin() + position, text.begin(), text.end());
+}
+
+template <typename... Parameters>
+void insert(GapBuffer<char, Parameters...>& gap_buffer, std::int64_t position, const std::string& text)
+{
+    gap_buffer.insert(make_crange(text), position);
+}
+
+template <typename Allocator, std::ptrdiff_t ChunkCapacity>
+void insert(ChunkedGapBuffer<char, Allocator, ChunkCapacity>& chunked_gap_buffer, std::int64_t position,
+    const std::string& text)
+{
+    chunked_gap_buffer.insert(make_crange(text), position);
+}
+
+template <typename Allocator>
+void insert(PieceTable<char, Allocator>& piece_table, std::int64_t position, const std::string& text)
+{
+    piece_table.insert(make_crange(text), position);
+}
+
+template <typename Container> void remove(Container& container, std::int64_t position, std::int64_t count)
+{
+    container.erase(container.begin() + position, container.begin() + position + count);
+}
+
+template <typename... Parameters>
+void remove(GapBuffer<char, Parameters...>& gap_buffer, std::int64_t position, std::int64_t count)
+{
+    gap_buffer.remove(position, count);
+}
+
+template <typename Allocator, std::ptrdiff_t ChunkCapacity>
+void remove(ChunkedGapBuffer<char, Allocator, ChunkCapacity>& chunked_gap_buffer, std::int64_t position,
+    std::int64_t count)
+{
+    chunked_gap_buffer.remove(position, count);
+}
+
+template <typename Allocator>
+void remove(PieceTable<char, Allocator>& piece_table, std::int64_t position, std::int64_t count)
+{
+    piece_table.remove(position, count);
+}
+
+template <typename Container>
+void replace(Container& container, std::int64_t position, std::int64_t count, const std::string& text)
+{
+    remove(container, position, count);
+    insert(container, position, text);
+}
+
+template <typename... Parameters>
+void replace(
+    GapBuffer<char, Parameters...>& gap_buffer, std::int64_t position, std::int64_t count, const std::string& text)
+{
+    gap_buffer.replace(position, count, make_crange(text));
+}
+
+template <typename Container> void typing(benchmark::State& state)
+{
+    auto container = make_container<Container>(make_text(state.range(0)));
+    const std::string typed = "typing at a single cursor ";
+    auto position = size(container) / 2;
+    auto typed_position = std::size_t{ 0 };
+    for (auto _ : state) {
+        insert(container, position, typed.substr(typed_position, 1));
+        position += 1;
+        typed_position = (typed_position + 1) % typed.size();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Container> void random_jumps(benchmark::State& state)
+{
+    auto container = make_container<Container>(make_text(state.range(0)));
+    const std::string word = "jump";
+    std::mt19937 random_engine;
+    for (auto _ : state) {
+        std::uniform_int_distribution<std::int64_t> position_distribution{ 0, size(container) };
+        const auto position = position_distribution(random_engine);
+        insert(container, position, word);
+        remove(container, position, static_cast<std::int64_t>(word.size()));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename Container> void bulk_paste(benchmark::State& state)
+{
+    auto container = make_container<Container>(make_text(state.range(0)));
+    const auto pasted = make_text(paste_size);
+    std::mt19937 random_engine;
+    for (auto _ : state) {
+        std::uniform_int_distribution<std::int64_t> position_distribution{ 0, size(container) };
+        const auto position = position_distribution(random_engine);
+        insert(container, position, pasted);
+        remove(container, position, paste_size);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * paste_size);
+}
+
+// Pastes lines into a buffer of lines, either copying them or moving them
+// from a payload that is rebuilt outside of the timing.
+void paste_lines(benchmark::State& state, bool is_moved)
+{
+    const auto text = make_text(state.range(0));
+    GapBuffer<std::string> gap_buffer;
+    for (std::int64_t position = 0; position < static_cast<std::int64_t>(text.size()); position += line_size + 1) {
+        gap_buffer.emplace(gap_buffer.size(), text, position, line_size);
+    }
+    const std::vector<std::string> lines(paste_size / line_size, text.substr(0, line_size));
+    const auto line_count = static_cast<std::int64_t>(lines.size());
+    std::mt19937 random_engine;
+    for (auto _ : state) {
+        std::uniform_int_distribution<std::int64_t> position_distribution{ 0, gap_buffer.size() };
+        const auto position = position_distribution(random_engine);
+        if (is_moved) {
+            state.PauseTiming();
+            auto pasted = lines;
+            state.ResumeTiming();
+            gap_buffer.move_insert(make_range(pasted), position);
+        } else {
+            gap_buffer.insert(make_crange(lines), position);
+        }
+        gap_buffer.remove(position, line_count);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * line_count);
+}
+
+void paste_lines_copied(benchmark::State& state) { paste_lines(state, false); }
+
+void paste_lines_moved(benchmark::State& state) { paste_lines(state, true); }
+
+// Moves a block between two buffers and back, either through an intermediate
+// string or by splicing it.
+void move_between_buffers(benchmark::State& state, bool is_spliced)
+{
+    auto source = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    auto destination = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    const auto block_size = std::min(paste_size, state.range(0) / 2);
+    std::mt19937 random_engine;
+    for (auto _ : state) {
+        std::uniform_int_distribution<std::int64_t> position_distribution{ 0, source.size() - block_size };
+        const auto source_position = position_distribution(random_engine);
+        std::uniform_int_distribution<std::int64_t> destination_position_distribution{ 0, destination.size() };
+        const auto position = destination_position_distribution(random_engine);
+        if (is_spliced) {
+            destination.splice(position, source, source_position, block_size);
+        } else {
+            const std::string block(std::next(source.cbegin(), source_position),
+                std::next(source.cbegin(), source_position + block_size));
+            source.remove(source_position, block_size);
+            destination.insert(make_crange(block), position);
+        }
+        std::swap(source, destination);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * block_size);
+}
+
+void move_between_buffers_copied(benchmark::State& state) { move_between_buffers(state, false); }
+
+void move_between_buffers_spliced(benchmark::State& state) { move_between_buffers(state, true); }
+
+template <typename Container> void iterate(benchmark::State& state)
+{
+    auto container = make_container<Container>(make_text(state.range(0)));
+    insert(container, size(container) / 2, "gap");
+    for (auto _ : state) {
+        auto newline_count = std::count(container.begin(), container.end(), '\n');
+        benchmark::DoNotOptimize(newline_count);
+    }
+    state.SetBytesProcessed(state.iterations() * size(container));
+}
+
+void segmented_iterate(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    for (auto _ : state) {
+        auto newline_count = segmented::count(gap_buffer, '\n');
+        benchmark::DoNotOptimize(newline_count);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+void typing_with_line_index(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    const std::string typed = "typing\n";
+    auto position = size(gap_buffer) / 2;
+    auto typed_position = std::size_t{ 0 };
+    for (auto _ : state) {
+        insert(gap_buffer, position, typed.substr(typed_position, 1));
+        position += 1;
+        typed_position = (typed_position + 1) % typed.size();
+        benchmark::ClobberMemory();
+    }
+    gap_buffer.remove_observer(&line_index);
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Appends lines to a buffer that keeps the last state.range(0) bytes, as a
+// terminal scrollback does, either by removing the front after each append
+// or with a size limit.
+void scrollback(benchmark::State& state, bool is_limited)
+{
+    const auto limit = state.range(0);
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(limit));
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    if (is_limited) {
+        gap_buffer.set_size_limit(limit);
+    }
+    const auto line = make_text(line_size);
+    for (auto _ : state) {
+        gap_buffer.append(make_crange(line));
+        if (!is_limited) {
+            gap_buffer.remove(0, gap_buffer.size() - limit);
+        }
+        benchmark::ClobberMemory();
+    }
+    gap_buffer.remove_observer(&line_index);
+    state.SetBytesProcessed(state.iterations() * line.size());
+}
+
+void scrollback_removing_front(benchmark::State& state) { scrollback(state, false); }
+
+void scrollback_with_size_limit(benchmark::State& state) { scrollback(state, true); }
+
+void typing_with_content_hash(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    ContentHash<char> content_hash;
+    gap_buffer.add_observer(&content_hash);
+    const std::string typed = "typing ";
+    auto position = size(gap_buffer) / 2;
+    auto typed_position = std::size_t{ 0 };
+    for (auto _ : state) {
+        insert(gap_buffer, position, typed.substr(typed_position, 1));
+        position += 1;
+        typed_position = (typed_position + 1) % typed.size();
+        auto digest = content_hash.digest();
+        benchmark::DoNotOptimize(digest);
+    }
+    gap_buffer.remove_observer(&content_hash);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void typing_with_code_point_index(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    CodePointIndex code_point_index;
+    gap_buffer.add_observer(&code_point_index);
+    const std::string typed = "\xe4\xb8\xad";
+    auto position = size(gap_buffer) / 2;
+    for (auto _ : state) {
+        insert(gap_buffer, position, typed);
+        position += typed.size();
+        auto code_point_count = code_point_index.code_point_count();
+        benchmark::DoNotOptimize(code_point_count);
+    }
+    gap_buffer.remove_observer(&code_point_index);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void typing_with_marks(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    MarkSet<char> mark_set;
+    gap_buffer.add_observer(&mark_set);
+    const auto mark_count = 10000;
+    for (auto mark = 0; mark < mark_count; ++mark) {
+        mark_set.add((size(gap_buffer) * mark) / mark_count, (mark % 2) ? Gravity::left : Gravity::right);
+    }
+    auto position = size(gap_buffer) / 2;
+    for (auto _ : state) {
+        insert(gap_buffer, position, "a");
+        position += 1;
+        benchmark::ClobberMemory();
+    }
+    gap_buffer.remove_observer(&mark_set);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void go_to_line(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<std::int64_t> line_distribution{ 0, line_index.line_count() - 1 };
+    for (auto _ : state) {
+        const auto offset = line_index.line_to_offset(line_distribution(random_engine));
+        benchmark::DoNotOptimize(line_index.offset_to_line(offset));
+    }
+    gap_buffer.remove_observer(&line_index);
+    state.SetItemsProcessed(state.iterations());
+}
+
+const std::string missing_needle = "qqqqz";
+
+void iterator_search(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    for (auto _ : state) {
+        auto found = std::search(gap_buffer.cbegin(), gap_buffer.cend(), missing_needle.begin(), missing_needle.end());
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+void kernel_search(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    for (auto _ : state) {
+        auto found = byte_search::search(
+            gap_buffer, 0, missing_needle.data(), missing_needle.data() + missing_needle.size());
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+// Searches for an identifier again after each keystroke, as an incremental
+// find does. Its trigrams do not occur in the random words, so the index
+// prunes every block but the edited ones.
+void indexed_search(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    TrigramIndex trigram_index;
+    gap_buffer.add_observer(&trigram_index);
+    const std::string needle = "cursor::GapBuffer";
+    auto position = size(gap_buffer) / 2;
+    insert(gap_buffer, position, "x");
+    trigram_index.search(gap_buffer, 0, needle.data(), needle.data() + needle.size());
+    for (auto _ : state) {
+        insert(gap_buffer, position, "x");
+        position += 1;
+        auto found = trigram_index.search(gap_buffer, 0, needle.data(), needle.data() + needle.size());
+        benchmark::DoNotOptimize(found);
+    }
+    gap_buffer.remove_observer(&trigram_index);
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+void kernel_count(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    for (auto _ : state) {
+        auto newline_count = byte_search::count(gap_buffer, '\n');
+        benchmark::DoNotOptimize(newline_count);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+void parallel_count(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    parallel::ThreadPool pool;
+    for (auto _ : state) {
+        auto newline_count = parallel::count(pool, gap_buffer, '\n');
+        benchmark::DoNotOptimize(newline_count);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+    state.counters["threads"] = pool.thread_count();
+}
+
+void parallel_find_all(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    parallel::ThreadPool pool;
+    for (auto _ : state) {
+        auto positions = parallel::find_all(pool, gap_buffer, missing_needle.data(),
+            missing_needle.data() + missing_needle.size());
+        benchmark::DoNotOptimize(positions);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+    state.counters["threads"] = pool.thread_count();
+}
+
+// Finds the column in code points of random offsets, as moving the cursor
+// between lines does.
+void code_point_column(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    LineIndex<char> line_index;
+    CodePointIndex code_point_index;
+    gap_buffer.add_observer(&line_index);
+    gap_buffer.add_observer(&code_point_index);
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<std::int64_t> offset_distribution{ 0, size(gap_buffer) };
+    for (auto _ : state) {
+        const auto offset = offset_distribution(random_engine);
+        const auto line_offset = line_index.line_to_offset(line_index.offset_to_line(offset));
+        const auto column = code_point_index.offset_to_code_point(gap_buffer, offset)
+            - code_point_index.offset_to_code_point(gap_buffer, line_offset);
+        benchmark::DoNotOptimize(column);
+    }
+    gap_buffer.remove_observer(&code_point_index);
+    gap_buffer.remove_observer(&line_index);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void kernel_utf8_validate(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    for (auto _ : state) {
+        auto is_valid = utf8::is_valid(gap_buffer);
+        benchmark::DoNotOptimize(is_valid);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+void kernel_utf8_count(benchmark::State& state)
+{
+    auto gap_buffer = make_container<GapBuffer<char>>(make_text(state.range(0)));
+    insert(gap_buffer, size(gap_buffer) / 2, "gap");
+    for (auto _ : state) {
+        auto code_point_count = utf8::count(gap_buffer, 0, size(gap_buffer));
+        benchmark::DoNotOptimize(code_point_count);
+    }
+    state.SetBytesProcessed(state.iterations() * size(gap_buffer));
+}
+
+template <typename Container> void replace_macro(benchmark::State& state)
+{
+    auto container = make_container<Container>(make_text(state.range(0)));
+    const std::string replacement = "macro";
+    const std::int64_t stride = line_size;
+    auto position = std::int64_t{ 0 };
+    for (auto _ : state) {
+        if ((position + stride) > size(container)) {
+            position = 0;
+        }
+        replace(container, position, static_cast<std::int64_t>(replacement.size()), replacement);
+        position += stride;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Replaces the start of every line, as a replace all or a multiple cursor
+// edit would, either one replace at a time from the end of the content or in
+// one batch.
+void replace_all(benchmark::State& state, bool is_batched)
+{
+    const auto text = make_text(state.range(0));
+    const std::string replacement = "macro";
+    std::vector<Edit<Range<std::string::const_iterator>>> edits;
+    for (std::int64_t position = 0; (position + line_size) <= static_cast<std::int64_t>(text.size()); position += line_size + 1) {
+        edits.push_back(make_edit(position, 4, make_crange(replacement)));
+    }
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto gap_buffer = make_container<GapBuffer<char>>(text);
+        state.ResumeTiming();
+        if (is_batched) {
+            benchmark::DoNotOptimize(gap_buffer.apply_edits(edits));
+        } else {
+            for (auto edit = edits.rbegin(); edit != edits.rend(); ++edit) {
+                gap_buffer.replace(edit->position, edit->count, edit->insert_range);
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * edits.size());
+}
+
+void replace_all_one_by_one(benchmark::State& state) { replace_all(state, false); }
+
+void replace_all_batched(benchmark::State& state) { replace_all(state, true); }
+
+void buffer_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(buffer_size_multiplier)->Range(min_buffer_size, max_buffer_size);
+}
+
+void edit_batch_buffer_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(buffer_size_multiplier)->Range(min_buffer_size, max_buffer_size / 32);
+}
+
+using CharGapBuffer = GapBuffer<char>;
+using CharString = std::string;
+using CharVector = std::vector<char>;
+using CharDeque = std::deque<char>;
+
+#define CURSOR_BENCHMARK_WORKLOAD(workload)                                                                            \
+    BENCHMARK_TEMPLATE(workload, CharGapBuffer)->Apply(buffer_sizes);                                                  \
+    BENCHMARK_TEMPLATE(workload, CharString)->Apply(buffer_sizes);                                                     \
+    BENCHMARK_TEMPLATE(workload, CharVector)->Apply(buffer_sizes);                                                     \
+    BENCHMARK_TEMPLATE(workload, CharDeque)->Apply(buffer_sizes)
+
+CURSOR_BENCHMARK_WORKLOAD(typing);
+CURSOR_BENCHMARK_WORKLOAD(random_jumps);
+CURSOR_BENCHMARK_WORKLOAD(bulk_paste);
+CURSOR_BENCHMARK_WORKLOAD(iterate);
+CURSOR_BENCHMARK_WORKLOAD(replace_macro);
+BENCHMARK(segmented_iterate)->Apply(buffer_sizes);
+BENCHMARK(typing_with_line_index)->Apply(buffer_sizes);
+BENCHMARK(typing_with_marks)->Apply(buffer_sizes);
+BENCHMARK(typing_with_content_hash)->Apply(buffer_sizes);
+BENCHMARK(typing_with_code_point_index)->Apply(buffer_sizes);
+BENCHMARK(scrollback_removing_front)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(scrollback_with_size_limit)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(replace_all_one_by_one)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(replace_all_batched)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(paste_lines_copied)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(paste_lines_moved)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(move_between_buffers_copied)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(move_between_buffers_spliced)->Apply(edit_batch_buffer_sizes);
+BENCHMARK(go_to_line)->Apply(buffer_sizes);
+BENCHMARK(iterator_search)->Apply(buffer_sizes);
+BENCHMARK(kernel_search)->Apply(buffer_sizes);
+BENCHMARK(indexed_search)->Apply(buffer_sizes);
+BENCHMARK(kernel_count)->Apply(buffer_sizes);
+BENCHMARK(parallel_count)->Apply(buffer_sizes);
+BENCHMARK(parallel_find_all)->Apply(buffer_sizes);
+BENCHMARK(code_point_column)->Apply(buffer_sizes);
+BENCHMARK(kernel_utf8_validate)->Apply(buffer_sizes);
+BENCHMARK(kernel_utf8_count)->Apply(buffer_sizes);
+
+BENCHMARK_TEMPLATE(typing, OneAndAHalfGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(typing, GapProportionalGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(bulk_paste, OneAndAHalfGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(bulk_paste, GapProportionalGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(typing, CharChunkedGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(random_jumps, CharChunkedGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(bulk_paste, CharChunkedGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(iterate, CharChunkedGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(typing, CharPieceTable)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(random_jumps, CharPieceTable)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(bulk_paste, CharPieceTable)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(iterate, CharPieceTable)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(typing, InstrumentedGapBuffer)->Apply(buffer_sizes);
+BENCHMARK_TEMPLATE(random_jumps, InstrumentedGapBuffer)->Apply(buffer_sizes);
+}
+}
+}
+}
+
+BENCHMARK_MAIN();
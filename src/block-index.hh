@@ -0,0 +1,325 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cursor {
+// A sequence of blocks, each covering a run of elements of some content and
+// carrying a summary of those elements, for indexes that need to aggregate
+// the summaries of any range of blocks. Summary must be default constructible
+// to the summary of no elements, and provide a static combine that returns
+// the summary of two adjacent runs from their summaries.
+//
+// The blocks are the nodes of a treap ordered by position, where each node
+// also holds the length and summary of its subtree, so locating a position,
+// changing a block and summarizing a range of blocks take O(log n). Blocks
+// are linked in order, and referred to by indexes into a pool of nodes that
+// stay valid until the block is erased.
+template<typename Summary>
+class BlockIndex {
+public:
+    using size_type = std::ptrdiff_t;
+    using block_type = std::ptrdiff_t;
+
+    static constexpr block_type no_block = -1;
+
+    size_type size() const { return subtree_length(root); }
+    size_type block_count() const { return block_count_; }
+    Summary summary() const { return subtree_summary(root); }
+
+    block_type first_block() const { return first; }
+    block_type last_block() const { return last; }
+    block_type next(block_type block) const { return nodes[block].next; }
+    block_type previous(block_type block) const { return nodes[block].previous; }
+
+    size_type length(block_type block) const { return nodes[block].length; }
+    const Summary& block_summary(block_type block) const { return nodes[block].summary; }
+
+    // Returns the number of elements before block.
+    size_type block_position(block_type block) const {
+        auto position = subtree_length(nodes[block].left);
+        for (; nodes[block].parent != no_block; block = nodes[block].parent) {
+            const auto parent = nodes[block].parent;
+            if (nodes[parent].right == block) {
+                position += subtree_length(nodes[parent].left) + nodes[parent].length;
+            }
+        }
+        return position;
+    }
+
+    // Returns the block that holds the element at position and the offset of
+    // the element in the block. The end of the content is located at the end
+    // of the last block.
+    std::pair<block_type, size_type> locate(size_type position) const {
+        if (position == size()) {
+            return {last, (last == no_block) ? 0 : nodes[last].length};
+        }
+        auto block = root;
+        while (true) {
+            const auto& node = nodes[block];
+            const auto left_length = subtree_length(node.left);
+            if (position < left_length) {
+                block = node.left;
+                continue;
+            }
+            position -= left_length;
+            if (position < node.length) {
+                return {block, position};
+            }
+            position -= node.length;
+            block = node.right;
+        }
+    }
+
+    // Returns the combined summary of the blocks that lie entirely within
+    // [first_position, last_position).
+    Summary summarize(size_type first_position, size_type last_position) const {
+        return summarize(root, 0, first_position, last_position);
+    }
+
+    // A block along with the position and the combined summary of the blocks
+    // before it.
+    struct Location {
+        block_type block;
+        size_type position;
+        Summary summary;
+    };
+
+    // Returns the first block for which predicate is true of the combined
+    // summary of the blocks up to and including it. The predicate must be
+    // false for no blocks and stay true once it is true, like a lower bound.
+    // If there is no such block, the location is no_block after every block.
+    template<typename Predicate>
+    Location search(Predicate predicate) const {
+        Location location{no_block, 0, Summary{}};
+        auto block = root;
+        while (block != no_block) {
+            const auto& node = nodes[block];
+            const auto left_summary = Summary::combine(location.summary, subtree_summary(node.left));
+            if (predicate(left_summary)) {
+                block = node.left;
+                continue;
+            }
+            const auto node_summary = Summary::combine(left_summary, node.summary);
+            if (predicate(node_summary)) {
+                location.block = block;
+                location.position += subtree_length(node.left);
+                location.summary = left_summary;
+                return location;
+            }
+            location.position += subtree_length(node.left) + node.length;
+            location.summary = node_summary;
+            block = node.right;
+        }
+        return location;
+    }
+
+    void update(block_type block, size_type length, const Summary& summary) {
+        nodes[block].length = length;
+        nodes[block].summary = summary;
+        for (; block != no_block; block = nodes[block].parent) {
+            update_subtree(block);
+        }
+    }
+
+    // Adds a block after previous, or before every block if previous is
+    // no_block, and returns it.
+    block_type insert_after(block_type previous, size_type length, const Summary& summary) {
+        const auto block = allocate_node();
+        auto& node = nodes[block];
+        node.length = length;
+        node.summary = summary;
+        node.priority = next_priority();
+        node.previous = previous;
+        node.next = (previous == no_block) ? first : nodes[previous].next;
+        if (node.next != no_block) {
+            nodes[node.next].previous = block;
+        } else {
+            last = block;
+        }
+        if (previous != no_block) {
+            nodes[previous].next = block;
+        } else {
+            first = block;
+        }
+
+        // The block becomes the right child of its predecessor or the left
+        // child of its successor, whichever has that child free.
+        if (root == no_block) {
+            root = block;
+        } else if ((previous != no_block) && (nodes[previous].right == no_block)) {
+            nodes[previous].right = block;
+            nodes[block].parent = previous;
+        } else {
+            const auto successor = nodes[block].next;
+            nodes[successor].left = block;
+            nodes[block].parent = successor;
+        }
+        for (auto ancestor = block; ancestor != no_block; ancestor = nodes[ancestor].parent) {
+            update_subtree(ancestor);
+        }
+        while ((nodes[block].parent != no_block) && (nodes[nodes[block].parent].priority < nodes[block].priority)) {
+            rotate_up(block);
+        }
+        block_count_ += 1;
+        return block;
+    }
+
+    void erase(block_type block) {
+        while ((nodes[block].left != no_block) || (nodes[block].right != no_block)) {
+            const auto left = nodes[block].left;
+            const auto right = nodes[block].right;
+            const auto use_left = (right == no_block) || ((left != no_block) && (nodes[left].priority > nodes[right].priority));
+            rotate_up(use_left ? left : right);
+        }
+        const auto parent = nodes[block].parent;
+        replace_child(parent, block, no_block);
+        for (auto ancestor = parent; ancestor != no_block; ancestor = nodes[ancestor].parent) {
+            update_subtree(ancestor);
+        }
+
+        const auto previous = nodes[block].previous;
+        const auto next = nodes[block].next;
+        if (previous != no_block) {
+            nodes[previous].next = next;
+        } else {
+            first = next;
+        }
+        if (next != no_block) {
+            nodes[next].previous = previous;
+        } else {
+            last = previous;
+        }
+        free_blocks.push_back(block);
+        block_count_ -= 1;
+    }
+
+    void clear() {
+        nodes.clear();
+        free_blocks.clear();
+        root = no_block;
+        first = no_block;
+        last = no_block;
+        block_count_ = 0;
+    }
+
+private:
+    struct Node {
+        size_type length = 0;
+        Summary summary;
+        size_type subtree_length = 0;
+        Summary subtree_summary;
+        std::uint32_t priority = 0;
+        block_type parent = no_block;
+        block_type left = no_block;
+        block_type right = no_block;
+        block_type previous = no_block;
+        block_type next = no_block;
+    };
+
+    size_type subtree_length(block_type block) const {
+        return (block == no_block) ? 0 : nodes[block].subtree_length;
+    }
+
+    Summary subtree_summary(block_type block) const {
+        return (block == no_block) ? Summary{} : nodes[block].subtree_summary;
+    }
+
+    void update_subtree(block_type block) {
+        auto& node = nodes[block];
+        node.subtree_length = subtree_length(node.left) + node.length + subtree_length(node.right);
+        node.subtree_summary = Summary::combine(Summary::combine(subtree_summary(node.left), node.summary),
+            subtree_summary(node.right));
+    }
+
+    Summary summarize(block_type block, size_type block_start, size_type first_position, size_type last_position) const {
+        if (block == no_block) {
+            return Summary{};
+        }
+        const auto& node = nodes[block];
+        const auto subtree_end = block_start + node.subtree_length;
+        if ((last_position <= block_start) || (first_position >= subtree_end)) {
+            return Summary{};
+        }
+        if ((first_position <= block_start) && (subtree_end <= last_position)) {
+            return node.subtree_summary;
+        }
+        const auto node_start = block_start + subtree_length(node.left);
+        const auto node_end = node_start + node.length;
+        const auto is_node_included = (first_position <= node_start) && (node_end <= last_position);
+        return Summary::combine(
+            Summary::combine(summarize(node.left, block_start, first_position, last_position),
+                is_node_included ? node.summary : Summary{}),
+            summarize(node.right, node_end, first_position, last_position));
+    }
+
+    block_type allocate_node() {
+        if (free_blocks.empty()) {
+            nodes.emplace_back();
+            return nodes.size() - 1;
+        }
+        const auto block = free_blocks.back();
+        free_blocks.pop_back();
+        nodes[block] = Node{};
+        return block;
+    }
+
+    std::uint32_t next_priority() {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return random_state;
+    }
+
+    void replace_child(block_type parent, block_type child, block_type new_child) {
+        if (parent == no_block) {
+            root = new_child;
+        } else if (nodes[parent].left == child) {
+            nodes[parent].left = new_child;
+        } else {
+            nodes[parent].right = new_child;
+        }
+        if (new_child != no_block) {
+            nodes[new_child].parent = parent;
+        }
+    }
+
+    // Makes block the parent of its parent, keeping the order of the blocks.
+    void rotate_up(block_type block) {
+        const auto parent = nodes[block].parent;
+        replace_child(nodes[parent].parent, parent, block);
+        if (nodes[parent].left == block) {
+            const auto moved = nodes[block].right;
+            nodes[parent].left = moved;
+            if (moved != no_block) {
+                nodes[moved].parent = parent;
+            }
+            nodes[block].right = parent;
+        } else {
+            const auto moved = nodes[block].left;
+            nodes[parent].right = moved;
+            if (moved != no_block) {
+                nodes[moved].parent = parent;
+            }
+            nodes[block].left = parent;
+        }
+        nodes[parent].parent = block;
+        update_subtree(parent);
+        update_subtree(block);
+    }
+
+    std::vector<Node> nodes;
+    std::vector<block_type> free_blocks;
+    block_type root = no_block;
+    block_type first = no_block;
+    block_type last = no_block;
+    size_type block_count_ = 0;
+    std::uint32_t random_state = 0x9e3779b9;
+};
+
+template<typename Summary>
+constexpr typename BlockIndex<Summary>::block_type BlockIndex<Summary>::no_block;
+
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+#include "gap-buffer.hh"
+#include "segmented-algorithm.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CURSOR_BYTE_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace cursor {
+namespace byte_search {
+// Instruction sets that the search kernels are implemented for. The best one
+// supported by the running processor is selected at runtime.
+enum class Isa {
+    scalar,
+    sse2,
+    avx2
+};
+
+namespace detail {
+inline std::ptrdiff_t count_scalar(const char* first, const char* last, char byte) {
+    std::ptrdiff_t byte_count = 0;
+    for (; first != last; ++first) {
+        byte_count += (*first == byte);
+    }
+    return byte_count;
+}
+
+inline const char* find_scalar(const char* first, const char* last, char byte) {
+    if (first == last) {
+        return last;
+    }
+    const auto found = std::memchr(first, static_cast<unsigned char>(byte), last - first);
+    return (found == nullptr) ? last : static_cast<const char*>(found);
+}
+
+inline const char* search_scalar(const char* first, const char* last, const char* needle, std::ptrdiff_t needle_size) {
+    const auto search_last = last - needle_size + 1;
+    while (first < search_last) {
+        first = find_scalar(first, search_last, needle[0]);
+        if (first == search_last) {
+            break;
+        }
+        if (std::memcmp(first + 1, needle + 1, needle_size - 1) == 0) {
+            return first;
+        }
+        ++first;
+    }
+    return last;
+}
+
+#ifdef CURSOR_BYTE_SEARCH_X86
+inline int count_trailing_zeros(unsigned int mask) {
+    return __builtin_ctz(mask);
+}
+
+__attribute__((target("sse2")))
+inline std::ptrdiff_t count_sse2(const char* first, const char* last, char byte) {
+    const auto pattern = _mm_set1_epi8(byte);
+    std::ptrdiff_t byte_count = 0;
+    for (; (last - first) >= 16; first += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+        byte_count += __builtin_popcount(mask);
+    }
+    return byte_count + count_scalar(first, last, byte);
+}
+
+__attribute__((target("sse2")))
+inline const char* find_sse2(const char* first, const char* last, char byte) {
+    const auto pattern = _mm_set1_epi8(byte);
+    for (; (last - first) >= 16; first += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, pattern)));
+        if (mask != 0) {
+            return first + count_trailing_zeros(mask);
+        }
+    }
+    return find_scalar(first, last, byte);
+}
+
+// Filters candidate positions by comparing the first and the last byte of the
+// needle at once, and only compares the remaining bytes for the candidates.
+__attribute__((target("sse2")))
+inline const char* search_sse2(const char* first, const char* last, const char* needle, std::ptrdiff_t needle_size) {
+    const auto first_pattern = _mm_set1_epi8(needle[0]);
+    const auto last_pattern = _mm_set1_epi8(needle[needle_size - 1]);
+    auto position = first;
+    for (; (last - position) >= (16 + needle_size - 1); position += 16) {
+        const auto first_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+        const auto last_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + needle_size - 1));
+        const auto matches = _mm_and_si128(_mm_cmpeq_epi8(first_block, first_pattern), _mm_cmpeq_epi8(last_block, last_pattern));
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(matches));
+        while (mask != 0) {
+            const auto candidate = position + count_trailing_zeros(mask);
+            if (std::memcmp(candidate + 1, needle + 1, needle_size - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return search_scalar(position, last, needle, needle_size);
+}
+
+__attribute__((target("avx2")))
+inline std::ptrdiff_t count_avx2(const char* first, const char* last, char byte) {
+    const auto pattern = _mm256_set1_epi8(byte);
+    std::ptrdiff_t byte_count = 0;
+    for (; (last - first) >= 32; first += 32) {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern)));
+        byte_count += __builtin_popcount(mask);
+    }
+    return byte_count + count_sse2(first, last, byte);
+}
+
+__attribute__((target("avx2")))
+inline const char* find_avx2(const char* first, const char* last, char byte) {
+    const auto pattern = _mm256_set1_epi8(byte);
+    for (; (last - first) >= 32; first += 32) {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, pattern)));
+        if (mask != 0) {
+            return first + count_trailing_zeros(mask);
+        }
+    }
+    return find_sse2(first, last, byte);
+}
+
+__attribute__((target("avx2")))
+inline const char* search_avx2(const char* first, const char* last, const char* needle, std::ptrdiff_t needle_size) {
+    const auto first_pattern = _mm256_set1_epi8(needle[0]);
+    const auto last_pattern = _mm256_set1_epi8(needle[needle_size - 1]);
+    auto position = first;
+    for (; (last - position) >= (32 + needle_size - 1); position += 32) {
+        const auto first_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position));
+        const auto last_block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(position + needle_size - 1));
+        const auto matches = _mm256_and_si256(
+            _mm256_cmpeq_epi8(first_block, first_pattern), _mm256_cmpeq_epi8(last_block, last_pattern));
+        auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(matches));
+        while (mask != 0) {
+            const auto candidate = position + count_trailing_zeros(mask);
+            if (std::memcmp(candidate + 1, needle + 1, needle_size - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return search_sse2(position, last, needle, needle_size);
+}
+#endif
+
+inline Isa select_isa() {
+#ifdef CURSOR_BYTE_SEARCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Isa::sse2;
+    }
+#endif
+    return Isa::scalar;
+}
+}
+
+inline Isa supported_isa() {
+    static const auto isa = detail::select_isa();
+    return isa;
+}
+
+inline bool is_supported(Isa isa) {
+    return static_cast<int>(isa) <= static_cast<int>(supported_isa());
+}
+
+inline std::ptrdiff_t count(const char* first, const char* last, char byte, Isa isa = supported_isa()) {
+    switch (isa) {
+#ifdef CURSOR_BYTE_SEARCH_X86
+    case Isa::avx2:
+        return detail::count_avx2(first, last, byte);
+    case Isa::sse2:
+        return detail::count_sse2(first, last, byte);
+#endif
+    default:
+        return detail::count_scalar(first, last, byte);
+    }
+}
+
+// Returns a pointer to the first occurrence of byte in [first, last), or last.
+inline const char* find(const char* first, const char* last, char byte, Isa isa = supported_isa()) {
+    switch (isa) {
+#ifdef CURSOR_BYTE_SEARCH_X86
+    case Isa::avx2:
+        return detail::find_avx2(first, last, byte);
+    case Isa::sse2:
+        return detail::find_sse2(first, last, byte);
+#endif
+    default:
+        return detail::find_scalar(first, last, byte);
+    }
+}
+
+// Returns a pointer to the first occurrence of the needle in [first, last),
+// or last.
+inline const char* search(const char* first, const char* last, const char* needle_first, const char* needle_last,
+    Isa isa = supported_isa()) {
+    const auto needle_size = needle_last - needle_first;
+    if (needle_size == 0) {
+        return first;
+    }
+    if ((last - first) < needle_size) {
+        return last;
+    }
+    if (needle_size == 1) {
+        return find(first, last, needle_first[0], isa);
+    }
+    switch (isa) {
+#ifdef CURSOR_BYTE_SEARCH_X86
+    case Isa::avx2:
+        return detail::search_avx2(first, last, needle_first, needle_size);
+    case Isa::sse2:
+        return detail::search_sse2(first, last, needle_first, needle_size);
+#endif
+    default:
+        return detail::search_scalar(first, last, needle_first, needle_size);
+    }
+}
+
+// Counts the occurrences of byte in the content before and after the gap.
+template<typename Segmented>
+std::ptrdiff_t count(const Segmented& segmented, char byte, Isa isa = supported_isa()) {
+    std::ptrdiff_t byte_count = 0;
+    segmented::for_each_segment(segmented, [&byte_count, byte, isa](const char* first, const char* last) {
+        byte_count += count(first, last, byte, isa);
+    });
+    return byte_count;
+}
+
+// Returns the position of the first occurrence of byte at or after position,
+// or the size of the content.
+template<typename Segmented>
+std::ptrdiff_t find(const Segmented& segmented, std::ptrdiff_t position, char byte, Isa isa = supported_isa()) {
+    const auto segments = segmented::segments_of(segmented);
+    const auto& before_gap = segments.before_gap;
+    const auto& after_gap = segments.after_gap;
+    if (position < before_gap.size()) {
+        const auto found = find(before_gap.begin() + position, before_gap.end(), byte, isa);
+        if (found != before_gap.end()) {
+            return found - before_gap.begin();
+        }
+        position = before_gap.size();
+    }
+    const auto after_gap_first = after_gap.begin() + (position - before_gap.size());
+    return before_gap.size() + (find(after_gap_first, after_gap.end(), byte, isa) - after_gap.begin());
+}
+
+// Returns the position of the first occurrence of the needle that starts at
+// or after position, or the size of the content. Occurrences that span the
+// gap start in the last needle size - 1 bytes before it, and each of those
+// starts is compared in place with the bytes on both sides of the gap, so
+// that searching near the gap does not allocate.
+template<typename Segmented>
+std::ptrdiff_t search(const Segmented& segmented, std::ptrdiff_t position, const char* needle_first,
+    const char* needle_last, Isa isa = supported_isa()) {
+    const auto segments = segmented::segments_of(segmented);
+    const auto& before_gap = segments.before_gap;
+    const auto& after_gap = segments.after_gap;
+    const auto content_size = before_gap.size() + after_gap.size();
+    const auto needle_size = needle_last - needle_first;
+    if ((content_size - position) < needle_size) {
+        return content_size;
+    }
+    if (needle_size == 0) {
+        return position;
+    }
+
+    if (position < before_gap.size()) {
+        const auto found = search(before_gap.begin() + position, before_gap.end(), needle_first, needle_last, isa);
+        if (found != before_gap.end()) {
+            return found - before_gap.begin();
+        }
+
+        for (auto start = std::max(position, before_gap.size() - (needle_size - 1)); start < before_gap.size(); ++start) {
+            const auto before_gap_count = before_gap.size() - start;
+            if (((needle_size - before_gap_count) <= after_gap.size())
+                && (std::memcmp(before_gap.begin() + start, needle_first, before_gap_count) == 0)
+                && (std::memcmp(after_gap.begin(), needle_first + before_gap_count, needle_size - before_gap_count) == 0)) {
+                return start;
+            }
+        }
+
+        position = before_gap.size();
+    }
+
+    const auto after_gap_first = after_gap.begin() + (position - before_gap.size());
+    const auto found = search(after_gap_first, after_gap.end(), needle_first, needle_last, isa);
+    if (found == after_gap.end()) {
+        return content_size;
+    }
+    return before_gap.size() + (found - after_gap.begin());
+}
+
+}
+}
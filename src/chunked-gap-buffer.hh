@@ -0,0 +1,554 @@
+#pragma once
+
+#include "gap-buffer.hh"
+#include "range.hh"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <cstddef>
+
+namespace cursor {
+// A sequence of elements stored in GapBuffer chunks of a fixed capacity, with
+// the same editing and iteration interface as GapBuffer. Each chunk keeps its
+// own gap, so an edit only moves elements within one chunk, and growing the
+// content allocates one more chunk instead of reallocating everything.
+//
+// The chunks are the nodes of a treap ordered by position, where each node
+// knows the number of elements in its subtree, so finding the chunk that
+// holds a position and updating the counts after an edit take O(log n). The
+// chunks are also linked in order, so iterating to the next chunk is O(1).
+// Chunks that become sparse after a removal are merged with a neighbour.
+template<typename Element, typename Allocator = std::allocator<Element>, std::ptrdiff_t ChunkCapacity = 64 * 1024>
+class ChunkedGapBuffer {
+    struct Chunk;
+
+public:
+    static_assert(ChunkCapacity >= 4, "Chunks must hold at least four elements");
+
+    template<typename Value>
+    class Iterator : public boost::iterator_facade<Iterator<Value>, Value, boost::random_access_traversal_tag> {
+    public:
+        using Facade = boost::iterator_facade<Iterator<Value>, Value, boost::random_access_traversal_tag>;
+        using difference_type = typename Facade::difference_type;
+        using value_type = typename Facade::value_type;
+        using pointer = typename Facade::pointer;
+        using reference = typename Facade::reference;
+        using iterator_category = typename Facade::iterator_category;
+
+        Iterator() {}
+
+        template<typename OtherValue, typename = std::enable_if_t<std::is_convertible<OtherValue*, Value*>::value>>
+        Iterator(const Iterator<OtherValue>& other) : owner{other.owner}, chunk{other.chunk}, offset{other.offset} {}
+
+    private:
+        friend class boost::iterator_core_access;
+        friend class ChunkedGapBuffer;
+
+        template<typename OtherValue>
+        friend class Iterator;
+
+        Iterator(const ChunkedGapBuffer* owner_, Chunk* chunk_, difference_type offset_)
+            : owner{owner_}, chunk{chunk_}, offset{offset_} {}
+
+        bool equal(const Iterator& other) const {
+            return (chunk == other.chunk) && (offset == other.offset);
+        }
+
+        reference dereference() const {
+            return chunk->at(offset);
+        }
+
+        void increment() {
+            offset += 1;
+            if (offset == chunk->size()) {
+                chunk = chunk->next;
+                offset = 0;
+            }
+        }
+
+        void decrement() {
+            if (chunk == nullptr) {
+                chunk = owner->last;
+                offset = chunk->size();
+            } else if (offset == 0) {
+                chunk = chunk->previous;
+                offset = chunk->size();
+            }
+            offset -= 1;
+        }
+
+        void advance(difference_type count) {
+            const auto new_offset = offset + count;
+            if ((chunk != nullptr) && (new_offset >= 0) && (new_offset < chunk->size())) {
+                offset = new_offset;
+                return;
+            }
+            const auto new_position = position() + count;
+            chunk = nullptr;
+            offset = 0;
+            if (new_position < owner->size()) {
+                std::tie(chunk, offset) = owner->locate(new_position);
+            }
+        }
+
+        difference_type distance_to(const Iterator& other) const {
+            return other.position() - position();
+        }
+
+        difference_type position() const {
+            return (chunk == nullptr) ? owner->size() : (owner->rank(chunk) + offset);
+        }
+
+        const ChunkedGapBuffer* owner = nullptr;
+        Chunk* chunk = nullptr;
+        difference_type offset = 0;
+    };
+
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<Element>;
+    using iterator = Iterator<Element>;
+    using const_iterator = Iterator<const Element>;
+    using size_type = std::ptrdiff_t;
+    using range = Range<iterator>;
+    using const_range = Range<const_iterator>;
+
+    static constexpr size_type chunk_capacity = ChunkCapacity;
+
+    ChunkedGapBuffer() {}
+
+    explicit ChunkedGapBuffer(const allocator_type& allocator_) : allocator{allocator_} {}
+
+    ChunkedGapBuffer(const ChunkedGapBuffer&) = delete;
+    ChunkedGapBuffer& operator=(const ChunkedGapBuffer&) = delete;
+
+    ChunkedGapBuffer(ChunkedGapBuffer&& other) noexcept : allocator{other.allocator} {
+        steal_chunks(other);
+    }
+
+    ChunkedGapBuffer& operator=(ChunkedGapBuffer&& other) noexcept {
+        if (this != &other) {
+            clear();
+            allocator = other.allocator;
+            steal_chunks(other);
+        }
+        return *this;
+    }
+
+    ~ChunkedGapBuffer() {
+        clear();
+    }
+
+    allocator_type get_allocator() const { return allocator; }
+
+    template<typename ElementRange>
+    void insert(ElementRange insert_range, size_type position) {
+        validate_position(position);
+        const auto count = static_cast<size_type>(insert_range.size());
+        if (count == 0) {
+            return;
+        }
+
+        Chunk* chunk;
+        size_type offset;
+        if (position == size()) {
+            if (last == nullptr) {
+                insert_chunk(nullptr);
+            }
+            chunk = last;
+            offset = last->size();
+        } else {
+            std::tie(chunk, offset) = locate(position);
+        }
+        if ((offset == 0) && (chunk->previous != nullptr) && ((chunk->previous->size() + count) <= ChunkCapacity)) {
+            chunk = chunk->previous;
+            offset = chunk->size();
+        }
+
+        if ((chunk->size() + count) <= ChunkCapacity) {
+            chunk->content.insert(insert_range, offset);
+            add_size(chunk, count);
+            return;
+        }
+
+        // Moves the elements after position to a chunk of their own, so that
+        // both halves of the split chunk have room for the next edits, and
+        // fills chunks between them with the inserted elements.
+        chunk->content.remove(offset, 0);
+        const auto tail = chunk->content.after_gap();
+        const auto tail_size = tail.size();
+        if (tail_size > 0) {
+            auto tail_chunk = insert_chunk(chunk);
+            tail_chunk->content.append(make_range(std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end())));
+            add_size(tail_chunk, tail_size);
+            chunk->content.remove(offset, tail_size);
+            add_size(chunk, -tail_size);
+        }
+        merge_if_sparse(append_to_chunks(chunk, insert_range.begin(), insert_range.end()));
+    }
+
+    template<typename ElementRange>
+    void insert(ElementRange insert_range, const_iterator element) {
+        insert(insert_range, element.position());
+    }
+
+    template<typename ElementRange>
+    void append(ElementRange append_range) {
+        insert(append_range, size());
+    }
+
+    void remove(size_type position, size_type count) {
+        validate_position(position);
+        if ((count < 0) || ((position + count) > size())) {
+            throw std::out_of_range("Invalid position");
+        }
+        if (count == 0) {
+            return;
+        }
+
+        auto located = locate(position);
+        auto chunk = located.first;
+        auto offset = located.second;
+        while (count > 0) {
+            const auto chunk_remove_count = std::min(count, chunk->size() - offset);
+            chunk->content.remove(offset, chunk_remove_count);
+            add_size(chunk, -chunk_remove_count);
+            count -= chunk_remove_count;
+            const auto next = chunk->next;
+            if (chunk->size() == 0) {
+                erase_chunk(chunk);
+            }
+            chunk = next;
+            offset = 0;
+        }
+
+        if (position < size()) {
+            chunk = locate(position).first;
+            merge_if_sparse(chunk);
+            if (chunk->previous != nullptr) {
+                merge_if_sparse(chunk->previous);
+            }
+        } else if (last != nullptr) {
+            merge_if_sparse(last->previous);
+        }
+    }
+
+    void remove(const_range remove_range) {
+        const auto position = remove_range.begin().position();
+        remove(position, remove_range.end().position() - position);
+    }
+
+    template<typename ElementRange>
+    void replace(size_type position, size_type count, ElementRange insert_range) {
+        remove(position, count);
+        insert(insert_range, position);
+    }
+
+    template<typename ElementRange>
+    void replace(const_range remove_range, ElementRange insert_range) {
+        const auto position = remove_range.begin().position();
+        replace(position, remove_range.end().position() - position, insert_range);
+    }
+
+    void clear() {
+        while (first != nullptr) {
+            auto next = first->next;
+            destroy_chunk(first);
+            first = next;
+        }
+        root = nullptr;
+        last = nullptr;
+        chunk_count_ = 0;
+    }
+
+    size_type size() const { return subtree_size(root); }
+    size_type chunk_count() const { return chunk_count_; }
+
+    iterator begin() { return iterator(this, first, 0); }
+    iterator end() { return iterator(this, nullptr, 0); }
+
+    const_iterator begin() const { return const_iterator(this, first, 0); }
+    const_iterator end() const { return const_iterator(this, nullptr, 0); }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // Calls function with the first and last pointer of every contiguous run
+    // of elements in order, which is the fast way to visit the content.
+    template<typename Function>
+    Function for_each_segment(Function function) const {
+        for (auto chunk = first; chunk != nullptr; chunk = chunk->next) {
+            const auto& content = chunk->content;
+            for (auto segment : {content.before_gap(), content.after_gap()}) {
+                if (segment.size() > 0) {
+                    function(segment.begin(), segment.end());
+                }
+            }
+        }
+        return function;
+    }
+
+private:
+    using ChunkAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Chunk>;
+    using ChunkAllocatorTraits = std::allocator_traits<ChunkAllocator>;
+
+    struct Chunk {
+        Chunk(const allocator_type& allocator, std::uint32_t priority_) : content{allocator}, priority{priority_} {
+            content.reserve(ChunkCapacity);
+        }
+
+        size_type size() const { return content.size(); }
+
+        Element& at(size_type offset) {
+            const auto before_gap = content.before_gap();
+            if (offset < before_gap.size()) {
+                return before_gap.begin()[offset];
+            }
+            return content.after_gap().begin()[offset - before_gap.size()];
+        }
+
+        GapBuffer<Element, allocator_type> content;
+        std::uint32_t priority;
+        size_type subtree_size = 0;
+        Chunk* parent = nullptr;
+        Chunk* left = nullptr;
+        Chunk* right = nullptr;
+        Chunk* previous = nullptr;
+        Chunk* next = nullptr;
+    };
+
+    void validate_position(size_type position) const {
+        if ((position < 0) || (position > size())) {
+            throw std::out_of_range("Invalid position");
+        }
+    }
+
+    static size_type subtree_size(const Chunk* chunk) {
+        return (chunk == nullptr) ? 0 : chunk->subtree_size;
+    }
+
+    static void update_subtree_size(Chunk* chunk) {
+        chunk->subtree_size = subtree_size(chunk->left) + chunk->size() + subtree_size(chunk->right);
+    }
+
+    static void add_size(Chunk* chunk, size_type count) {
+        for (; chunk != nullptr; chunk = chunk->parent) {
+            chunk->subtree_size += count;
+        }
+    }
+
+    // Returns the chunk that holds the element at position and the offset of
+    // the element in the chunk.
+    std::pair<Chunk*, size_type> locate(size_type position) const {
+        auto chunk = root;
+        while (true) {
+            const auto left_size = subtree_size(chunk->left);
+            if (position < left_size) {
+                chunk = chunk->left;
+                continue;
+            }
+            position -= left_size;
+            if (position < chunk->size()) {
+                return {chunk, position};
+            }
+            position -= chunk->size();
+            chunk = chunk->right;
+        }
+    }
+
+    // Returns the number of elements before chunk.
+    size_type rank(const Chunk* chunk) const {
+        auto position = subtree_size(chunk->left);
+        for (; chunk->parent != nullptr; chunk = chunk->parent) {
+            if (chunk == chunk->parent->right) {
+                position += subtree_size(chunk->parent->left) + chunk->parent->size();
+            }
+        }
+        return position;
+    }
+
+    std::uint32_t next_priority() {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        return random_state;
+    }
+
+    Chunk* create_chunk() {
+        ChunkAllocator chunk_allocator{allocator};
+        auto chunk = ChunkAllocatorTraits::allocate(chunk_allocator, 1);
+        try {
+            ChunkAllocatorTraits::construct(chunk_allocator, chunk, allocator, next_priority());
+        } catch (...) {
+            ChunkAllocatorTraits::deallocate(chunk_allocator, chunk, 1);
+            throw;
+        }
+        return chunk;
+    }
+
+    void destroy_chunk(Chunk* chunk) {
+        ChunkAllocator chunk_allocator{allocator};
+        ChunkAllocatorTraits::destroy(chunk_allocator, chunk);
+        ChunkAllocatorTraits::deallocate(chunk_allocator, chunk, 1);
+    }
+
+    void replace_child(Chunk* parent, Chunk* child, Chunk* new_child) {
+        if (parent == nullptr) {
+            root = new_child;
+        } else if (parent->left == child) {
+            parent->left = new_child;
+        } else {
+            parent->right = new_child;
+        }
+        if (new_child != nullptr) {
+            new_child->parent = parent;
+        }
+    }
+
+    // Makes chunk the parent of its parent, keeping the order of the chunks.
+    void rotate_up(Chunk* chunk) {
+        auto parent = chunk->parent;
+        replace_child(parent->parent, parent, chunk);
+        if (chunk == parent->left) {
+            parent->left = chunk->right;
+            if (chunk->right != nullptr) {
+                chunk->right->parent = parent;
+            }
+            chunk->right = parent;
+        } else {
+            parent->right = chunk->left;
+            if (chunk->left != nullptr) {
+                chunk->left->parent = parent;
+            }
+            chunk->left = parent;
+        }
+        parent->parent = chunk;
+        update_subtree_size(parent);
+        update_subtree_size(chunk);
+    }
+
+    // Links a new empty chunk after previous, or before every chunk if
+    // previous is null.
+    Chunk* insert_chunk(Chunk* previous) {
+        auto chunk = create_chunk();
+        chunk->previous = previous;
+        chunk->next = (previous == nullptr) ? first : previous->next;
+        if (chunk->next != nullptr) {
+            chunk->next->previous = chunk;
+        } else {
+            last = chunk;
+        }
+        if (previous != nullptr) {
+            previous->next = chunk;
+        } else {
+            first = chunk;
+        }
+
+        // The chunk becomes the left child of its successor or the right
+        // child of its predecessor, whichever has that child free.
+        if (root == nullptr) {
+            root = chunk;
+        } else if ((previous != nullptr) && (previous->right == nullptr)) {
+            previous->right = chunk;
+            chunk->parent = previous;
+        } else {
+            chunk->next->left = chunk;
+            chunk->parent = chunk->next;
+        }
+        while ((chunk->parent != nullptr) && (chunk->parent->priority < chunk->priority)) {
+            rotate_up(chunk);
+        }
+        chunk_count_ += 1;
+        return chunk;
+    }
+
+    // Unlinks and destroys an empty chunk.
+    void erase_chunk(Chunk* chunk) {
+        while ((chunk->left != nullptr) || (chunk->right != nullptr)) {
+            const auto use_left = (chunk->right == nullptr)
+                || ((chunk->left != nullptr) && (chunk->left->priority > chunk->right->priority));
+            rotate_up(use_left ? chunk->left : chunk->right);
+        }
+        replace_child(chunk->parent, chunk, nullptr);
+
+        if (chunk->previous != nullptr) {
+            chunk->previous->next = chunk->next;
+        } else {
+            first = chunk->next;
+        }
+        if (chunk->next != nullptr) {
+            chunk->next->previous = chunk->previous;
+        } else {
+            last = chunk->previous;
+        }
+        destroy_chunk(chunk);
+        chunk_count_ -= 1;
+    }
+
+    // Appends the elements to chunk, continuing in new chunks after it when
+    // it is full, and returns the chunk that holds the last element.
+    template<typename InputIterator>
+    Chunk* append_to_chunks(Chunk* chunk, InputIterator first_element, InputIterator last_element) {
+        while (first_element != last_element) {
+            if (chunk->size() == ChunkCapacity) {
+                chunk = insert_chunk(chunk);
+            }
+            const auto room = ChunkCapacity - chunk->size();
+            auto piece_end = first_element;
+            size_type piece_size = 0;
+            for (; (piece_end != last_element) && (piece_size < room); ++piece_end, ++piece_size) {
+            }
+            chunk->content.append(make_range(first_element, piece_end));
+            add_size(chunk, piece_size);
+            first_element = piece_end;
+        }
+        return chunk;
+    }
+
+    // Merges chunk with the chunk after it if together they fill at most half
+    // a chunk.
+    void merge_if_sparse(Chunk* chunk) {
+        if ((chunk == nullptr) || (chunk->next == nullptr)) {
+            return;
+        }
+        auto next = chunk->next;
+        const auto next_size = next->size();
+        if ((chunk->size() + next_size) > (ChunkCapacity / 2)) {
+            return;
+        }
+        for (auto segment : {next->content.before_gap(), next->content.after_gap()}) {
+            chunk->content.append(make_range(std::make_move_iterator(segment.begin()), std::make_move_iterator(segment.end())));
+        }
+        add_size(chunk, next_size);
+        next->content.clear();
+        add_size(next, -next_size);
+        erase_chunk(next);
+    }
+
+    void steal_chunks(ChunkedGapBuffer& other) {
+        root = other.root;
+        first = other.first;
+        last = other.last;
+        chunk_count_ = other.chunk_count_;
+        random_state = other.random_state;
+        other.root = nullptr;
+        other.first = nullptr;
+        other.last = nullptr;
+        other.chunk_count_ = 0;
+    }
+
+    allocator_type allocator;
+    Chunk* root = nullptr;
+    Chunk* first = nullptr;
+    Chunk* last = nullptr;
+    size_type chunk_count_ = 0;
+    std::uint32_t random_state = 0x9e3779b9;
+};
+
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "block-index.hh"
+#include "gap-buffer.hh"
+#include "segmented-algorithm.hh"
+#include "utf8.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+namespace cursor {
+// The number of code points in a run of UTF-8 bytes.
+struct CodePointCount {
+    static CodePointCount combine(const CodePointCount& lhs, const CodePointCount& rhs) {
+        return {lhs.count + rhs.count};
+    }
+
+    std::ptrdiff_t count = 0;
+};
+
+// Counts the code points of a GapBuffer<char> of UTF-8 it observes, so that
+// byte offsets and code point indexes can be converted in O(log n) instead of
+// decoding from the start of the line. The column of an offset in code points
+// is the difference between the code point index of the offset and that of
+// the start of its line, as found with a LineIndex.
+//
+// The content is divided into blocks of at most max_block_size bytes, whose
+// code point counts are kept in a BlockIndex. Since every byte but a
+// continuation byte starts a code point, the blocks do not need to end on a
+// code point, and an edit only counts the bytes it inserts or removes.
+class CodePointIndex : public GapBufferObserver<char> {
+public:
+    using size_type = std::ptrdiff_t;
+
+    static constexpr size_type max_block_size = 1024;
+
+private:
+    using block_type = BlockIndex<CodePointCount>::block_type;
+
+    static constexpr block_type no_block = BlockIndex<CodePointCount>::no_block;
+
+public:
+    void reset(const Segments<const char>& content) override {
+        blocks.clear();
+        insert_blocks(content, no_block, 0, segmented::size(content));
+    }
+
+    void inserted(const Segments<const char>& content, size_type position, size_type count) override {
+        if (count == 0) {
+            return;
+        }
+        const auto located = blocks.locate(position);
+        auto block = located.first;
+        if (block == no_block) {
+            insert_blocks(content, no_block, position, count);
+            return;
+        }
+        if ((located.second == 0) && (blocks.previous(block) != no_block)) {
+            block = blocks.previous(block);
+        }
+
+        // A block that grows past the maximum size is counted again in blocks
+        // of half the maximum size, so that typing splits a block once every
+        // half a block.
+        const auto length = blocks.length(block) + count;
+        if (length <= max_block_size) {
+            const auto code_point_count = blocks.block_summary(block).count + utf8::count(content, position, count);
+            blocks.update(block, length, {code_point_count});
+            return;
+        }
+        insert_blocks(content, block, blocks.block_position(block), length);
+        blocks.erase(block);
+    }
+
+    void removing(const Segments<const char>& content, size_type position, size_type count) override {
+        if (count == 0) {
+            return;
+        }
+        auto located = blocks.locate(position);
+        auto block = located.first;
+        auto offset = located.second;
+        for (auto removed_position = position; removed_position < (position + count);) {
+            const auto removed_count = std::min(position + count - removed_position, blocks.length(block) - offset);
+            const auto next = blocks.next(block);
+            const auto length = blocks.length(block) - removed_count;
+            if (length == 0) {
+                blocks.erase(block);
+            } else {
+                const auto code_point_count = blocks.block_summary(block).count
+                    - utf8::count(content, removed_position, removed_count);
+                blocks.update(block, length, {code_point_count});
+            }
+            removed_position += removed_count;
+            block = next;
+            offset = 0;
+        }
+
+        if (blocks.block_count() == 0) {
+            return;
+        }
+        block = (position < blocks.size()) ? blocks.locate(position).first : blocks.last_block();
+        block = merge_if_small(block, blocks.previous(block));
+        merge_if_small(block, blocks.next(block));
+    }
+
+    size_type code_point_count() const {
+        return blocks.summary().count;
+    }
+
+    // Returns the number of code points that start before offset. The buffer
+    // must be the one the index observes.
+    template<typename GapBufferType>
+    size_type offset_to_code_point(const GapBufferType& gap_buffer, size_type offset) const {
+        if ((offset < 0) || (offset > blocks.size())) {
+            throw std::out_of_range("Invalid offset");
+        }
+        if (offset == blocks.size()) {
+            return code_point_count();
+        }
+        const auto located = blocks.locate(offset);
+        const auto block_position = offset - located.second;
+        return blocks.summarize(0, block_position).count + utf8::count(gap_buffer.csegments(), block_position, located.second);
+    }
+
+    // Returns the offset of the start of code point, or the size of the
+    // content for the code point one past the last. The buffer must be the
+    // one the index observes.
+    template<typename GapBufferType>
+    size_type code_point_to_offset(const GapBufferType& gap_buffer, size_type code_point) const {
+        if ((code_point < 0) || (code_point > code_point_count())) {
+            throw std::out_of_range("Invalid code point");
+        }
+        const auto location = blocks.search([code_point](const CodePointCount& code_point_count_) {
+            return code_point_count_.count > code_point;
+        });
+        if (location.block == no_block) {
+            return blocks.size();
+        }
+        return utf8::find_code_point(gap_buffer.csegments(), location.position, code_point - location.summary.count);
+    }
+
+    size_type block_count() const {
+        return blocks.block_count();
+    }
+
+private:
+    // Adds blocks of half the maximum size for the length bytes at position
+    // after previous.
+    void insert_blocks(const Segments<const char>& content, block_type previous, size_type position, size_type length) {
+        const auto piece_size = max_block_size / 2;
+        for (auto piece_position = position; piece_position < (position + length); piece_position += piece_size) {
+            const auto piece_length = std::min(piece_size, position + length - piece_position);
+            previous = blocks.insert_after(previous, piece_length, {utf8::count(content, piece_position, piece_length)});
+        }
+    }
+
+    // Joins block with neighbour, one of the blocks next to it, when block is
+    // under a quarter of the maximum size and both fit in one block. Returns
+    // the block that remains.
+    block_type merge_if_small(block_type block, block_type neighbour) {
+        if ((neighbour == no_block) || (blocks.length(block) >= (max_block_size / 4))
+            || ((blocks.length(block) + blocks.length(neighbour)) > max_block_size)) {
+            return block;
+        }
+        const auto first = (neighbour == blocks.previous(block)) ? neighbour : block;
+        const auto second = blocks.next(first);
+        const auto code_point_count = CodePointCount::combine(blocks.block_summary(first), blocks.block_summary(second));
+        blocks.update(first, blocks.length(first) + blocks.length(second), code_point_count);
+        blocks.erase(second);
+        return first;
+    }
+
+    BlockIndex<CodePointCount> blocks;
+};
+
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "block-index.hh"
+#include "gap-buffer.hh"
+#include "segmented-algorithm.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace cursor {
+// A polynomial hash of a run of elements modulo the Mersenne prime 2^61 - 1,
+// kept with the power of the base for the length of the run. The hash of two
+// adjacent runs follows from their hashes, which is what lets ContentHash
+// update and combine the hashes of blocks without reading their content.
+struct PolynomialHash {
+    static constexpr std::uint64_t modulus = (std::uint64_t{1} << 61) - 1;
+    static constexpr std::uint64_t base = 0x1f3d5b79a2c4e687 % modulus;
+
+    static PolynomialHash combine(const PolynomialHash& lhs, const PolynomialHash& rhs) {
+        return {add(multiply(lhs.hash, rhs.power), rhs.hash), multiply(lhs.power, rhs.power)};
+    }
+
+    // Returns the hash of the run with value appended.
+    PolynomialHash append(std::uint64_t value) const {
+        return {add(multiply(hash, base), value % modulus), multiply(power, base)};
+    }
+
+    static std::uint64_t add(std::uint64_t lhs, std::uint64_t rhs) {
+        const auto sum = lhs + rhs;
+        return (sum >= modulus) ? (sum - modulus) : sum;
+    }
+
+    // Multiplies in 32 bit halves, folding the bits above 2^61 back in since
+    // 2^61 is 1 modulo the modulus.
+    static std::uint64_t multiply(std::uint64_t lhs, std::uint64_t rhs) {
+        const auto lhs_low = lhs & 0xffffffff;
+        const auto lhs_high = lhs >> 32;
+        const auto rhs_low = rhs & 0xffffffff;
+        const auto rhs_high = rhs >> 32;
+        const auto low = lhs_low * rhs_low;
+        const auto middle = (lhs_low * rhs_high) + (lhs_high * rhs_low);
+        const auto high = lhs_high * rhs_high;
+        auto product = (low & modulus) + (low >> 61) + (high << 3) + (middle >> 29) + ((middle << 35) >> 3) + 1;
+        product = (product & modulus) + (product >> 61);
+        product = (product & modulus) + (product >> 61);
+        return product - 1;
+    }
+
+    std::uint64_t hash = 0;
+    std::uint64_t power = 1;
+};
+
+// Maintains a hash of the content of a GapBuffer it observes, so that the
+// buffer can be compared with a saved version or checked for changes without
+// reading it. The digest of the whole content is always at hand, and the
+// hash of any range takes O(log n).
+//
+// The content is divided into blocks of at most max_block_size elements,
+// whose hashes are combined in a BlockIndex. An edit rehashes the blocks it
+// touches, and the hashes of the blocks around them are combined as they
+// are. Since the hash is polynomial rather than a Merkle tree over fixed
+// blocks, it only depends on the content and not on where the blocks fall,
+// so digest_of gives the same value for the same elements from any source.
+template<typename Element>
+class ContentHash : public GapBufferObserver<Element> {
+public:
+    static_assert(std::is_integral<Element>::value, "Elements must be integral");
+
+    using size_type = std::ptrdiff_t;
+
+    static constexpr size_type max_block_size = 4096;
+
+private:
+    using block_type = BlockIndex<PolynomialHash>::block_type;
+
+    static constexpr block_type no_block = BlockIndex<PolynomialHash>::no_block;
+
+public:
+    void reset(const Segments<const Element>& content) override {
+        blocks.clear();
+        const auto content_size = segmented::size(content);
+        auto previous = no_block;
+        for (size_type position = 0; position < content_size; position += max_block_size / 2) {
+            const auto length = std::min(max_block_size / 2, content_size - position);
+            previous = blocks.insert_after(previous, length, hash_of(content, position, length));
+        }
+    }
+
+    // Inserts split the block they land in, and the inserted elements extend
+    // the part before the insert, so that typing at one place only hashes
+    // the typed elements after the first one.
+    void inserted(const Segments<const Element>& content, size_type position, size_type count) override {
+        if (count == 0) {
+            return;
+        }
+        auto located = blocks.locate(position);
+        auto block = located.first;
+        auto offset = located.second;
+        if (block == no_block) {
+            insert_pieces(content, no_block, position, count);
+            return;
+        }
+        if ((offset == 0) && (blocks.previous(block) != no_block)) {
+            block = blocks.previous(block);
+            offset = blocks.length(block);
+        }
+
+        const auto length = blocks.length(block);
+        auto tail = no_block;
+        if (offset < length) {
+            const auto tail_length = length - offset;
+            tail = blocks.insert_after(block, tail_length, hash_of(content, position + count, tail_length));
+            blocks.update(block, offset, hash_of(content, position - offset, offset));
+        }
+        if ((offset + count) <= max_block_size) {
+            const auto hash = PolynomialHash::combine(blocks.block_summary(block), hash_of(content, position, count));
+            blocks.update(block, offset + count, hash);
+        } else {
+            insert_pieces(content, block, position, count);
+            if (offset == 0) {
+                blocks.erase(block);
+                block = no_block;
+            }
+        }
+        if (tail != no_block) {
+            merge_if_small(tail, blocks.next(tail));
+        }
+        if (block != no_block) {
+            merge_if_small(block, blocks.previous(block));
+        }
+    }
+
+    void removing(const Segments<const Element>& content, size_type position, size_type count) override {
+        if (count == 0) {
+            return;
+        }
+        const auto end_position = position + count;
+        const auto first = blocks.locate(position);
+        const auto last = blocks.locate(end_position - 1);
+        const auto tail_length = blocks.length(last.first) - (last.second + 1);
+
+        // The removed range leaves the head of its first block and the tail of
+        // its last one, which are joined into one block.
+        const auto head = hash_of(content, position - first.second, first.second);
+        const auto tail = hash_of(content, end_position, tail_length);
+        if (first.first != last.first) {
+            auto block = blocks.next(first.first);
+            while (true) {
+                const auto next = blocks.next(block);
+                blocks.erase(block);
+                if (block == last.first) {
+                    break;
+                }
+                block = next;
+            }
+        }
+        const auto length = first.second + tail_length;
+        if (length == 0) {
+            blocks.erase(first.first);
+            return;
+        }
+        blocks.update(first.first, length, PolynomialHash::combine(head, tail));
+        const auto block = merge_if_small(first.first, blocks.previous(first.first));
+        merge_if_small(block, blocks.next(block));
+    }
+
+    // Returns the hash of the whole content.
+    std::uint64_t digest() const {
+        return blocks.summary().hash;
+    }
+
+    // Returns the hash of the count elements at position, which is the digest
+    // that a buffer holding only those elements would have. The buffer must be
+    // the one the index observes.
+    template<typename GapBufferType>
+    std::uint64_t hash(const GapBufferType& gap_buffer, size_type position, size_type count) const {
+        if ((position < 0) || (count < 0) || ((position + count) > blocks.size())) {
+            throw std::out_of_range("Invalid position");
+        }
+        if (count == 0) {
+            return 0;
+        }
+        const auto content = gap_buffer.csegments();
+        const auto end_position = position + count;
+        const auto first = blocks.locate(position);
+        const auto last = blocks.locate(end_position - 1);
+        if (first.first == last.first) {
+            return hash_of(content, position, count).hash;
+        }
+        const auto first_end = position - first.second + blocks.length(first.first);
+        const auto last_position = end_position - (last.second + 1);
+        const auto head = hash_of(content, position, first_end - position);
+        const auto middle = blocks.summarize(first_end, last_position);
+        const auto tail = hash_of(content, last_position, last.second + 1);
+        return PolynomialHash::combine(PolynomialHash::combine(head, middle), tail).hash;
+    }
+
+    // Returns the digest that a buffer holding the elements of range has.
+    template<typename ElementRange>
+    static std::uint64_t digest_of(const ElementRange& range) {
+        PolynomialHash hash;
+        for (const auto element : range) {
+            hash = hash.append(to_value(element));
+        }
+        return hash.hash;
+    }
+
+    size_type block_count() const {
+        return blocks.block_count();
+    }
+
+private:
+    // Elements are offset by one so that leading zeros change the hash.
+    static std::uint64_t to_value(Element element) {
+        return static_cast<std::uint64_t>(static_cast<std::make_unsigned_t<Element>>(element)) + 1;
+    }
+
+    static PolynomialHash hash_of(const Segments<const Element>& content, size_type position, size_type count) {
+        PolynomialHash hash;
+        segmented::for_each_segment(content, position, count, [&hash](const Element* first, const Element* last) {
+            for (; first != last; ++first) {
+                hash = hash.append(to_value(*first));
+            }
+        });
+        return hash;
+    }
+
+    // Adds blocks of half the maximum size for the length elements at
+    // position after previous.
+    void insert_pieces(const Segments<const Element>& content, block_type previous, size_type position,
+        size_type length) {
+        const auto piece_size = max_block_size / 2;
+        for (auto piece_position = position; piece_position < (position + length); piece_position += piece_size) {
+            const auto piece_length = std::min(piece_size, position + length - piece_position);
+            previous = blocks.insert_after(previous, piece_length, hash_of(content, piece_position, piece_length));
+        }
+    }
+
+    // Joins block with neighbour, one of the blocks next to it, when block is
+    // under a quarter of the maximum size and both fit in one block. Their
+    // hashes are combined without reading the content. Returns the block
+    // that remains.
+    block_type merge_if_small(block_type block, block_type neighbour) {
+        if ((neighbour == no_block) || (blocks.length(block) >= (max_block_size / 4))
+            || ((blocks.length(block) + blocks.length(neighbour)) > max_block_size)) {
+            return block;
+        }
+        const auto first = (neighbour == blocks.previous(block)) ? neighbour : block;
+        const auto second = blocks.next(first);
+        const auto hash = PolynomialHash::combine(blocks.block_summary(first), blocks.block_summary(second));
+        blocks.update(first, blocks.length(first) + blocks.length(second), hash);
+        blocks.erase(second);
+        return first;
+    }
+
+    BlockIndex<PolynomialHash> blocks;
+};
+
+template<typename Element>
+constexpr typename ContentHash<Element>::size_type ContentHash<Element>::max_block_size;
+
+template<typename Element>
+constexpr typename ContentHash<Element>::block_type ContentHash<Element>::no_block;
+
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "arena-allocator.hh"
+#include "gap-buffer.hh"
+#include "range.hh"
+#include "segmented-algorithm.hh"
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace cursor {
+// Records the edits made to a GapBuffer it observes, so that they can be
+// undone and redone. Attaching the journal is what opts a buffer in to
+// journaling, and undo and redo must be given the buffer the journal is
+// attached to.
+//
+// Each record only keeps the position and size of an edit and the elements
+// that the buffer no longer holds: removed elements, and inserted elements
+// once the insert has been undone. Those elements live in an arena owned by
+// the journal, so the many small records of a session share a few large
+// allocations. Single elements typed one after the other are coalesced into
+// one record until a newline is typed or the journal is sealed.
+//
+// Replacing the content, by attaching the journal or loading a file, clears
+// the journal. Elements dropped from the front by the size limit of the
+// buffer are not recorded and cannot be brought back: the records are moved
+// back with the content, and the records that reach into the dropped
+// elements are discarded along with the older ones and any redo.
+template<typename Element>
+class EditJournal : public GapBufferObserver<Element> {
+public:
+    using size_type = std::ptrdiff_t;
+
+    explicit EditJournal(Element newline_ = Element('\n')) : newline{newline_} {}
+
+    void reset(const Segments<const Element>&) override {
+        if (!applying) {
+            records.clear();
+            applied_count = 0;
+            is_sealed = true;
+        }
+    }
+
+    void inserted(const Segments<const Element>& content, size_type position, size_type count) override {
+        if (applying || (count == 0)) {
+            return;
+        }
+        const auto is_typed = (count == 1);
+        if (is_typed && can_coalesce(position)) {
+            records.back().count += 1;
+        } else {
+            push_record(Record::Kind::insert, position, count);
+        }
+        is_sealed = !is_typed || (element_at(content, position) == newline);
+    }
+
+    void removing(const Segments<const Element>& content, size_type position, size_type count) override {
+        if (applying || (count == 0)) {
+            return;
+        }
+        auto& record = push_record(Record::Kind::remove, position, count);
+        segmented::copy(content, position, count, std::back_inserter(record.elements));
+        is_sealed = true;
+    }
+
+    void trimming(const Segments<const Element>&, size_type count) override {
+        records.erase(records.begin() + applied_count, records.end());
+        auto first_kept = applied_count;
+        while ((first_kept > 0) && (records[first_kept - 1].position >= count)) {
+            first_kept -= 1;
+        }
+        // A group is undone as a whole or not at all.
+        if (first_kept > 0) {
+            while ((first_kept < applied_count) && records[first_kept].is_grouped_with_previous) {
+                first_kept += 1;
+            }
+        }
+        records.erase(records.begin(), records.begin() + first_kept);
+        applied_count -= first_kept;
+        for (auto& record : records) {
+            record.position -= count;
+        }
+    }
+
+    // Ends the current coalesced record, so that the next typed element
+    // starts a new one.
+    void seal() {
+        is_sealed = true;
+    }
+
+    // Records between begin_group and the matching end_group are undone and
+    // redone as one step. Groups nest, with only the outermost one counting.
+    void begin_group() {
+        if (group_depth == 0) {
+            group_size = 0;
+        }
+        group_depth += 1;
+        is_sealed = true;
+    }
+
+    void end_group() {
+        group_depth -= 1;
+        is_sealed = true;
+    }
+
+    bool can_undo() const {
+        return applied_count > 0;
+    }
+
+    bool can_redo() const {
+        return applied_count < static_cast<size_type>(records.size());
+    }
+
+    size_type record_count() const {
+        return records.size();
+    }
+
+    // Undoes the most recent step that has not been undone, and returns
+    // whether there was one.
+    template<typename GapBufferType>
+    bool undo(GapBufferType& gap_buffer) {
+        if (!can_undo()) {
+            return false;
+        }
+        Applying applying_scope{*this};
+        auto is_grouped = true;
+        while (is_grouped && can_undo()) {
+            applied_count -= 1;
+            auto& record = records[applied_count];
+            is_grouped = record.is_grouped_with_previous;
+            if (record.kind == Record::Kind::insert) {
+                record.elements.clear();
+                segmented::copy(gap_buffer.csegments(), record.position, record.count, std::back_inserter(record.elements));
+                gap_buffer.remove(record.position, record.count);
+            } else {
+                gap_buffer.insert(make_crange(record.elements), record.position);
+            }
+        }
+        return true;
+    }
+
+    // Redoes the most recently undone step, and returns whether there was
+    // one.
+    template<typename GapBufferType>
+    bool redo(GapBufferType& gap_buffer) {
+        if (!can_redo()) {
+            return false;
+        }
+        Applying applying_scope{*this};
+        // The record counts as applied before it is, as an insert that makes
+        // the buffer trim its front moves the applied records.
+        do {
+            applied_count += 1;
+            const auto& record = records[applied_count - 1];
+            if (record.kind == Record::Kind::insert) {
+                gap_buffer.insert(make_crange(record.elements), record.position);
+            } else {
+                gap_buffer.remove(record.position, record.count);
+            }
+        } while (can_redo() && records[applied_count].is_grouped_with_previous);
+        return true;
+    }
+
+private:
+    using Elements = std::vector<Element, ArenaAllocator<Element>>;
+
+    struct Record {
+        enum class Kind {
+            insert,
+            remove
+        };
+
+        Record(Kind kind_, size_type position_, size_type count_, bool is_grouped_with_previous_, Arena& arena)
+            : kind{kind_}, position{position_}, count{count_}, is_grouped_with_previous{is_grouped_with_previous_},
+              elements{ArenaAllocator<Element>{arena}} {}
+
+        Kind kind;
+        size_type position;
+        size_type count;
+        bool is_grouped_with_previous;
+        Elements elements;
+    };
+
+    class Applying {
+    public:
+        explicit Applying(EditJournal& journal_) : journal(journal_) {
+            journal.applying = true;
+            journal.is_sealed = true;
+        }
+
+        ~Applying() {
+            journal.applying = false;
+        }
+
+    private:
+        EditJournal& journal;
+    };
+
+    static Element element_at(const Segments<const Element>& content, size_type position) {
+        const auto before_gap_size = content.before_gap.size();
+        return (position < before_gap_size) ? content.before_gap.begin()[position]
+                                            : content.after_gap.begin()[position - before_gap_size];
+    }
+
+    bool can_coalesce(size_type position) const {
+        if (is_sealed || !can_undo() || can_redo()) {
+            return false;
+        }
+        const auto& record = records.back();
+        return (record.kind == Record::Kind::insert) && ((record.position + record.count) == position);
+    }
+
+    Record& push_record(typename Record::Kind kind, size_type position, size_type count) {
+        records.erase(records.begin() + applied_count, records.end());
+        const auto is_grouped_with_previous = (group_depth > 0) && (group_size > 0);
+        records.emplace_back(kind, position, count, is_grouped_with_previous, arena);
+        applied_count += 1;
+        group_size += 1;
+        return records.back();
+    }
+
+    Element newline;
+    Arena arena;
+    std::vector<Record> records;
+    size_type applied_count = 0;
+    size_type group_depth = 0;
+    size_type group_size = 0;
+    bool is_sealed = true;
+    bool applying = false;
+};
+
+}
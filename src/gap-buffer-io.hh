@@ -0,0 +1,262 @@
+#pragma once
+
+#include "gap-buffer.hh"
+#include "page-allocator.hh"
+#include "piece-table.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace cursor {
+namespace io {
+// How save writes to an existing file. overwrite truncates and rewrites the
+// file in place. atomic_replace writes a temporary file next to it, syncs it
+// and renames it over the original, so readers and crashes only ever see the
+// old or the new content.
+enum class SaveMode {
+    overwrite,
+    atomic_replace
+};
+
+namespace detail {
+constexpr std::ptrdiff_t read_chunk_size = 8 << 20;
+constexpr std::ptrdiff_t min_gap_size = 4096;
+
+inline std::system_error make_system_error(const std::string& what) {
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+class File {
+public:
+    File(const std::string& path, int flags, mode_t mode = 0) : descriptor{::open(path.c_str(), flags | O_CLOEXEC, mode)} {
+        if (descriptor < 0) {
+            throw make_system_error("Failed to open " + path);
+        }
+    }
+
+    explicit File(int descriptor_) : descriptor{descriptor_} {}
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File() {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+    }
+
+    int get() const { return descriptor; }
+
+    std::ptrdiff_t size() const {
+        struct stat status;
+        if (::fstat(descriptor, &status) != 0) {
+            throw make_system_error("Failed to stat file");
+        }
+        return status.st_size;
+    }
+
+    // Closes the descriptor, reporting the errors that close can surface for
+    // written files.
+    void close() {
+        const auto result = ::close(descriptor);
+        descriptor = -1;
+        if (result != 0) {
+            throw make_system_error("Failed to close file");
+        }
+    }
+
+private:
+    int descriptor;
+};
+
+// Reads count bytes at offset into destination in chunks aligned to
+// read_chunk_size in the file.
+inline void read_fully(const File& file, char* destination, std::ptrdiff_t offset, std::ptrdiff_t count) {
+    while (count > 0) {
+        const auto chunk_size = std::min(count, read_chunk_size - (offset % read_chunk_size));
+        const auto result = ::pread(file.get(), destination, chunk_size, offset);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw make_system_error("Failed to read file");
+        }
+        if (result == 0) {
+            throw std::runtime_error("File was truncated while reading");
+        }
+        destination += result;
+        offset += result;
+        count -= result;
+    }
+}
+
+inline void sync(const File& file) {
+    if (::fsync(file.get()) != 0) {
+        throw make_system_error("Failed to sync file");
+    }
+}
+
+inline std::string directory_of(const std::string& path) {
+    const auto separator = path.rfind('/');
+    if (separator == std::string::npos) {
+        return ".";
+    }
+    return (separator == 0) ? "/" : path.substr(0, separator);
+}
+
+inline std::ptrdiff_t default_gap_size(std::ptrdiff_t file_size) {
+    return std::max(file_size / 64, min_gap_size);
+}
+}
+
+// Replaces the content of the buffer with the content of the file at path,
+// reading straight into the buffer storage on either side of a gap placed at
+// gap_position.
+template<typename GapBufferType>
+void load(GapBufferType& gap_buffer, const std::string& path, std::ptrdiff_t gap_position = 0) {
+    const detail::File file{path, O_RDONLY};
+    const auto file_size = file.size();
+    if ((gap_position < 0) || (gap_position > file_size)) {
+        throw std::out_of_range("Invalid position");
+    }
+    ::posix_fadvise(file.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    gap_buffer.assign_for_overwrite(file_size, gap_position, detail::default_gap_size(file_size),
+        [&file, gap_position](const auto& segments) {
+            detail::read_fully(file, segments.before_gap.begin(), 0, segments.before_gap.size());
+            detail::read_fully(file, segments.after_gap.begin(), gap_position, segments.after_gap.size());
+        });
+}
+
+// Writes the content of the buffer to descriptor with vectored writes over
+// the segments before and after the gap, so nothing is copied in between.
+template<typename GapBufferType>
+void write_to(const GapBufferType& gap_buffer, int descriptor) {
+    const auto segments = gap_buffer.csegments();
+    iovec vectors[] = {
+        {const_cast<char*>(segments.before_gap.begin()), static_cast<std::size_t>(segments.before_gap.size())},
+        {const_cast<char*>(segments.after_gap.begin()), static_cast<std::size_t>(segments.after_gap.size())}
+    };
+    auto vector = std::begin(vectors);
+    const auto vectors_end = std::end(vectors);
+    while (vector != vectors_end) {
+        if (vector->iov_len == 0) {
+            ++vector;
+            continue;
+        }
+        auto result = ::writev(descriptor, vector, vectors_end - vector);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw detail::make_system_error("Failed to write file");
+        }
+        for (; (vector != vectors_end) && (static_cast<std::size_t>(result) >= vector->iov_len); ++vector) {
+            result -= vector->iov_len;
+        }
+        if (vector != vectors_end) {
+            vector->iov_base = static_cast<char*>(vector->iov_base) + result;
+            vector->iov_len -= result;
+        }
+    }
+}
+
+// Writes the content of the buffer to the file at path. A file created by
+// atomic_replace takes the permissions of the file it replaces, or 0644 if
+// there was none.
+template<typename GapBufferType>
+void save(const GapBufferType& gap_buffer, const std::string& path, SaveMode mode = SaveMode::atomic_replace) {
+    if (mode == SaveMode::overwrite) {
+        detail::File file{path, O_WRONLY | O_CREAT | O_TRUNC, 0666};
+        write_to(gap_buffer, file.get());
+        file.close();
+        return;
+    }
+
+    std::string temporary_path = path + ".XXXXXX";
+    const auto descriptor = ::mkstemp(&temporary_path[0]);
+    if (descriptor < 0) {
+        throw detail::make_system_error("Failed to create a temporary file for " + path);
+    }
+    detail::File file{descriptor};
+    try {
+        struct stat status;
+        const auto permissions = (::stat(path.c_str(), &status) == 0) ? (status.st_mode & 07777) : 0644;
+        if (::fchmod(file.get(), permissions) != 0) {
+            throw detail::make_system_error("Failed to set the permissions of " + temporary_path);
+        }
+        write_to(gap_buffer, file.get());
+        detail::sync(file);
+        file.close();
+        if (::rename(temporary_path.c_str(), path.c_str()) != 0) {
+            throw detail::make_system_error("Failed to rename " + temporary_path + " to " + path);
+        }
+    } catch (...) {
+        ::unlink(temporary_path.c_str());
+        throw;
+    }
+
+    const detail::File directory{detail::directory_of(path), O_RDONLY | O_DIRECTORY};
+    detail::sync(directory);
+}
+
+// Replaces the content of the buffer with a private mapping of the file at
+// path, placed after a gap at the start of the buffer. The pages of the
+// mapping are only read when they are first accessed and stay backed by the
+// file until they are written, so the part of the file after the first edit
+// costs no anonymous memory until the gap moves over it. As with any private
+// mapping, the file must not be truncated while it is mapped.
+template<typename GrowthPolicy>
+void map(GapBuffer<char, PageAllocator<char>, GrowthPolicy>& gap_buffer, const std::string& path) {
+    const detail::File file{path, O_RDONLY};
+    const auto file_size = file.size();
+    const auto gap_size = static_cast<std::ptrdiff_t>(PageAllocator<char>::round_to_pages(detail::default_gap_size(file_size)));
+    gap_buffer.assign_for_overwrite(file_size, 0, gap_size, [&file](const auto& segments) {
+        const auto& after_gap = segments.after_gap;
+        if (after_gap.size() == 0) {
+            return;
+        }
+        const auto mapping = ::mmap(after_gap.begin(), after_gap.size(), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_FIXED, file.get(), 0);
+        if (mapping == MAP_FAILED) {
+            throw detail::make_system_error("Failed to map file");
+        }
+    });
+}
+
+// Replaces the content of the piece table with a shared read only mapping of
+// the file at path, which becomes its original. The mapping is unmapped when
+// the last table sharing it lets it go. As with map for a GapBuffer, the file
+// must not be truncated while it is mapped.
+template<typename Allocator>
+void map(PieceTable<char, Allocator>& piece_table, const std::string& path) {
+    const detail::File file{path, O_RDONLY};
+    const auto file_size = file.size();
+    if (file_size == 0) {
+        piece_table.clear();
+        return;
+    }
+    const auto mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file.get(), 0);
+    if (mapping == MAP_FAILED) {
+        throw detail::make_system_error("Failed to map file");
+    }
+    std::shared_ptr<const char> original{static_cast<const char*>(mapping), [file_size](const char* mapping_) {
+        ::munmap(const_cast<char*>(mapping_), file_size);
+    }};
+    piece_table.assign(std::move(original), file_size);
+}
+
+}
+}
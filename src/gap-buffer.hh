@@ -1,18 +1,99 @@
 #pragma once
 
+#include "growth-policy.hh"
+#include "instrumentation.hh"
 #include "range.hh"
 
 #include <boost/iterator/iterator_facade.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 
 namespace cursor {
 template<typename Element>
+struct Segments {
+    Range<Element*> before_gap;
+    Range<Element*> after_gap;
+};
+
+// Receives notifications of the edits made to a GapBuffer it is attached to.
+// removing is called before elements are removed, removed and inserted after
+// the buffer has been updated, so content always describes a consistent
+// buffer. reset is called when the observer is attached. trimming and
+// trimmed are called around dropping elements from the front to fit the
+// size limit, and are a removal at position 0 unless overridden.
+template<typename Element>
+class GapBufferObserver {
+public:
+    using size_type = std::ptrdiff_t;
+
+    virtual ~GapBufferObserver() {}
+
+    virtual void reset(const Segments<const Element>& content) = 0;
+    virtual void inserted(const Segments<const Element>&, size_type, size_type) {}
+    virtual void removing(const Segments<const Element>&, size_type, size_type) {}
+    virtual void removed(const Segments<const Element>&, size_type, size_type) {}
+
+    virtual void trimming(const Segments<const Element>& content, size_type count) {
+        removing(content, 0, count);
+    }
+
+    virtual void trimmed(const Segments<const Element>& content, size_type count) {
+        removed(content, 0, count);
+    }
+};
+
+// One of the edits applied by GapBuffer::apply_edits. It replaces the count
+// elements at position with the elements of insert_range, where position
+// refers to the content before any of the edits are applied.
+template<typename ElementRange>
+struct Edit {
+    std::ptrdiff_t position;
+    std::ptrdiff_t count;
+    ElementRange insert_range;
+};
+
+template<typename ElementRange>
+Edit<ElementRange> make_edit(std::ptrdiff_t position, std::ptrdiff_t count, ElementRange insert_range) {
+    return {position, count, insert_range};
+}
+
+// How GapBuffer::view makes a range that spans the gap contiguous. move_gap
+// moves the gap to whichever end of the range is nearer, which leaves the
+// content in place for later views. copy copies the range to a scratch
+// buffer and leaves the gap where the next edit wants it.
+enum class ViewPolicy {
+    move_gap,
+    copy
+};
+
+#ifndef CURSOR_CHECKED_ITERATORS
+#define CURSOR_CHECKED_ITERATORS 0
+#endif
+
+// Points at an element of a GapBuffer or at its end. The iterator only holds
+// a pointer to the element and the bounds of the gap, which is enough to step
+// over the gap and to measure distances across it.
+//
+// Defining CURSOR_CHECKED_ITERATORS to 1 makes iterators of a GapBuffer also
+// remember the version of the buffer they were made from, and throw
+// std::logic_error when they are used after an edit of the buffer has
+// invalidated them, or compared with an iterator of another buffer. Every
+// translation unit of a program must agree on the setting.
+template<typename Element>
 class GapBufferIterator : public boost::iterator_facade<GapBufferIterator<Element>, Element, boost::random_access_traversal_tag> {
 public:
     using Facade = boost::iterator_facade<GapBufferIterator<Element>, Element, boost::random_access_traversal_tag>;
@@ -22,133 +103,330 @@ public:
     using reference = typename Facade::reference;
     using iterator_category = typename Facade::iterator_category;
 
-    GapBufferIterator(pointer buffer_, difference_type buffer_position_, difference_type buffer_size_, difference_type gap_position_, difference_type gap_size_)
-        : buffer{buffer_}, buffer_position{buffer_position_}, buffer_size{buffer_size_}, gap_position{gap_position_}, gap_size{gap_size_} {}
+    GapBufferIterator() {}
+
+#if CURSOR_CHECKED_ITERATORS
+    GapBufferIterator(pointer element_, pointer gap_begin_, pointer gap_end_, const std::size_t* version_source_)
+        : element{element_}, gap_begin{gap_begin_}, gap_end{gap_end_}, version_source{version_source_},
+          version{(version_source_ == nullptr) ? 0 : *version_source_} {}
+#else
+    GapBufferIterator(pointer element_, pointer gap_begin_, pointer gap_end_)
+        : element{element_}, gap_begin{gap_begin_}, gap_end{gap_end_} {}
+#endif
+
+    template<typename OtherElement, typename = std::enable_if_t<std::is_convertible<OtherElement*, Element*>::value>>
+    GapBufferIterator(const GapBufferIterator<OtherElement>& other)
+        : element{other.element}, gap_begin{other.gap_begin}, gap_end{other.gap_end}
+#if CURSOR_CHECKED_ITERATORS
+          , version_source{other.version_source}, version{other.version}
+#endif
+    {}
 
 private:
     friend class boost::iterator_core_access;
 
+    template<typename OtherElement>
+    friend class GapBufferIterator;
+
     bool equal(const GapBufferIterator& other) const {
-        assert(is_other_iterator_valid(other));
-        assert(is_buffer_position_valid());
-        assert(other.is_buffer_position_valid());
-        return buffer_position == other.buffer_position;
+        check(other);
+        return element == other.element;
     }
 
     reference dereference() const {
-        assert(is_buffer_position_valid());
-        return buffer[buffer_position];
+        check();
+        assert((element < gap_begin) || (element >= gap_end));
+        return *element;
     }
 
     void increment() {
-        if ((buffer_position + 1) == gap_position) {
-            assert(buffer_position < (buffer_size - gap_size));
-            buffer_position += (1 + gap_size);
-        } else {
-            assert(buffer_position < buffer_size);
-            buffer_position += 1;
+        check();
+        ++element;
+        if (element == gap_begin) {
+            element = gap_end;
         }
-        assert(is_buffer_position_valid());
     }
 
     void decrement() {
-        if (buffer_position == (gap_position + gap_size)) {
-            assert(buffer_position > gap_size);
-            buffer_position -= (1 + gap_size);
-        } else {
-            assert(buffer_position > 0);
-            buffer_position -= 1;
+        check();
+        if (element == gap_end) {
+            element = gap_begin;
         }
-        assert(is_buffer_position_valid());
+        --element;
     }
 
     void advance(difference_type count) {
-        if (count == 0) {
-            return;
-        } else if (count > 0) {
-            if ((buffer_position < gap_position) && ((buffer_position + count) >= gap_position)) {
-                assert(buffer_position <= (buffer_size - count - gap_size));
-                buffer_position += (count + gap_size);
-            } else {
-                assert(buffer_position <= (buffer_size - count));
-                buffer_position += count;
-            }
-        } else {
-            if ((buffer_position >= gap_size) && ((buffer_position - count) < gap_size)) {
-                assert(buffer_position >= (count + gap_size));
-                buffer_position -= (count + gap_size);
-            } else {
-                assert(buffer_position >= count);
-                buffer_position -= count;
-            }
-        }
-        assert(is_buffer_position_valid());
+        check();
+        const auto new_offset = offset_from_gap() + count;
+        element = (new_offset < 0) ? (gap_begin + new_offset) : (gap_end + new_offset);
     }
 
     difference_type distance_to(const GapBufferIterator& other) const {
-        assert(is_other_iterator_valid(other));
-        assert(is_buffer_position_valid());
-        assert(other.is_buffer_position_valid());
-
-        const auto is_before_gap = (buffer_position < gap_position);
-        const auto is_after_gap = (buffer_position >= (gap_position + gap_size));
+        check(other);
+        return other.offset_from_gap() - offset_from_gap();
+    }
 
-        const auto is_other_before_gap = (other.buffer_position < gap_position);
-        const auto is_other_after_gap = (other.buffer_position >= (gap_position + gap_size));
+    // The number of elements between the gap and the element, negative for
+    // elements before the gap.
+    difference_type offset_from_gap() const {
+        return (element < gap_begin) ? (element - gap_begin) : (element - gap_end);
+    }
 
-        if (is_before_gap && is_other_after_gap) {
-            return (other.buffer_position - gap_size) - buffer_position;
-        } else if (is_after_gap && is_other_before_gap) {
-            return other.buffer_position - (buffer_position - gap_size);
-        } else {
-            return other.buffer_position - buffer_position;
+#if CURSOR_CHECKED_ITERATORS
+    void check() const {
+        if ((version_source != nullptr) && (*version_source != version)) {
+            throw std::logic_error("Use of an invalidated iterator");
         }
     }
 
-    bool is_other_iterator_valid(const GapBufferIterator& other) const {
-        if (buffer != other.buffer) { return false; }
-        if (buffer_size != other.buffer_size) { return false; }
-        if (gap_position != other.gap_position) { return false; }
-        if (gap_size != other.gap_size) { return false; }
-        return true;
+    void check(const GapBufferIterator& other) const {
+        check();
+        other.check();
+        if ((gap_begin != other.gap_begin) || (gap_end != other.gap_end)) {
+            throw std::logic_error("Use of iterators of different buffers");
+        }
     }
+#else
+    void check() const {}
 
-    bool is_buffer_position_valid() const {
-        if (buffer_position > buffer_size) { return false; }
-        if ((buffer_position != buffer_size) && (buffer_position >= gap_position) && (buffer_position < (gap_position + gap_size))) { return false; }
-        return true;
+    void check(const GapBufferIterator& other) const {
+        assert((gap_begin == other.gap_begin) && (gap_end == other.gap_end));
+        (void)other;
     }
+#endif
 
-    pointer buffer;
-    difference_type buffer_position = 0;
-    difference_type buffer_size = 0;
-    difference_type gap_position = 0;
-    difference_type gap_size = 0;
+    pointer element = nullptr;
+    pointer gap_begin = nullptr;
+    pointer gap_end = nullptr;
+#if CURSOR_CHECKED_ITERATORS
+    const std::size_t* version_source = nullptr;
+    std::size_t version = 0;
+#endif
 };
 
 
+template<typename Element, typename Allocator, typename GrowthPolicy, typename Instrumentation>
+class GapBuffer;
+
+// An immutable view of the content of a GapBuffer at the time it was taken.
+// Snapshots share the storage of the buffer until the buffer is next
+// modified, at which point the buffer copies the storage if a snapshot still
+// refers to it. A snapshot can be copied and read on any thread without
+// synchronizing with the buffer, and keeps the storage alive after the
+// buffer is destroyed.
 template<typename Element>
+class GapBufferSnapshot {
+public:
+    using const_iterator = GapBufferIterator<const Element>;
+    using iterator = const_iterator;
+    using size_type = typename const_iterator::difference_type;
+
+    GapBufferSnapshot() {}
+
+    size_type size() const { return buffer_size - gap_size; }
+
+    const_iterator begin() const {
+        return make_iterator((gap_position == 0) ? (buffer + gap_size) : buffer);
+    }
+    const_iterator end() const {
+        return make_iterator(buffer + buffer_size);
+    }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    Segments<const Element> segments() const {
+        return Segments<const Element>{before_gap(), after_gap()};
+    }
+    Segments<const Element> csegments() const { return segments(); }
+
+    Range<const Element*> before_gap() const {
+        return make_range(buffer, buffer + gap_position);
+    }
+    Range<const Element*> after_gap() const {
+        return make_range(buffer + gap_position + gap_size, buffer + buffer_size);
+    }
+
+private:
+    template<typename, typename, typename, typename>
+    friend class GapBuffer;
+
+    GapBufferSnapshot(std::shared_ptr<const void> storage_, const Element* buffer_, size_type buffer_size_,
+        size_type gap_position_, size_type gap_size_)
+        : storage{std::move(storage_)}, buffer{buffer_}, buffer_size{buffer_size_}, gap_position{gap_position_},
+          gap_size{gap_size_} {}
+
+    const_iterator make_iterator(const Element* element) const {
+#if CURSOR_CHECKED_ITERATORS
+        return const_iterator(element, buffer + gap_position, buffer + gap_position + gap_size, nullptr);
+#else
+        return const_iterator(element, buffer + gap_position, buffer + gap_position + gap_size);
+#endif
+    }
+
+    std::shared_ptr<const void> storage;
+    const Element* buffer = nullptr;
+    size_type buffer_size = 0;
+    size_type gap_position = 0;
+    size_type gap_size = 0;
+};
+
+template<typename Element, typename Allocator = std::allocator<Element>, typename GrowthPolicy = DoublingGrowthPolicy,
+    typename Instrumentation = NullInstrumentation>
 class GapBuffer {
 public:
-    using Buffer = std::unique_ptr<Element[]>;
+    using allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<Element>;
+    using growth_policy_type = GrowthPolicy;
+    using instrumentation_type = Instrumentation;
     using iterator = GapBufferIterator<Element>;
     using const_iterator = GapBufferIterator<const Element>;
     using size_type = typename iterator::difference_type;
     using range = Range<iterator>;
     using const_range = Range<const_iterator>;
+    using observer_type = GapBufferObserver<Element>;
+    using snapshot_type = GapBufferSnapshot<Element>;
 
-    template<typename ElementRange>
-    void insert(ElementRange insert_range, size_type position) {
-        validate_position(position);
+    GapBuffer() {}
 
-        move_gap(position);
-        expand_gap(insert_range.size());
+    explicit GapBuffer(const allocator_type& allocator_, const GrowthPolicy& growth_policy_ = GrowthPolicy{},
+        const ShrinkPolicy& shrink_policy_ = ShrinkPolicy{})
+        : allocator{allocator_}, growth_policy{growth_policy_}, shrink_policy{shrink_policy_}, view_scratch{allocator_} {}
 
-        auto gap_begin = buffer_begin() + gap_position;
-        std::copy(insert_range.begin(), insert_range.end(), gap_begin);
+    GapBuffer(const GapBuffer&) = delete;
+    GapBuffer& operator=(const GapBuffer&) = delete;
+
+    GapBuffer(GapBuffer&& other) noexcept
+        : allocator{std::move(other.allocator)}, growth_policy{std::move(other.growth_policy)},
+          shrink_policy{other.shrink_policy}, observers{std::move(other.observers)},
+          instrumentation{std::move(other.instrumentation)}, size_limit{other.size_limit},
+          view_scratch{std::move(other.view_scratch)} {
+        steal_buffer(other);
+    }
+
+    GapBuffer& operator=(GapBuffer&& other) {
+        if (this != &other) {
+            move_assign(other, typename AllocatorTraits::propagate_on_container_move_assignment{});
+        }
+        return *this;
+    }
+
+    ~GapBuffer() {
+        deallocate();
+    }
 
-        gap_position += insert_range.size();
-        gap_size -= insert_range.size();
+    void swap(GapBuffer& other) noexcept {
+        using std::swap;
+        swap_allocator(other, typename AllocatorTraits::propagate_on_container_swap{});
+        swap(growth_policy, other.growth_policy);
+        swap(shrink_policy, other.shrink_policy);
+        swap(observers, other.observers);
+        swap(instrumentation, other.instrumentation);
+        swap(size_limit, other.size_limit);
+        swap(shared_storage, other.shared_storage);
+        swap(front_size, other.front_size);
+        swap(buffer, other.buffer);
+        swap(buffer_size, other.buffer_size);
+        swap(gap_position, other.gap_position);
+        swap(gap_size, other.gap_size);
+        swap(view_scratch, other.view_scratch);
+        invalidate_iterators();
+        other.invalidate_iterators();
+    }
+
+    allocator_type get_allocator() const { return allocator; }
+    const GrowthPolicy& get_growth_policy() const { return growth_policy; }
+
+    // The instrumentation follows the content when the buffer is moved or
+    // swapped.
+    const Instrumentation& get_instrumentation() const { return instrumentation; }
+    Instrumentation& get_instrumentation() { return instrumentation; }
+
+    const ShrinkPolicy& get_shrink_policy() const { return shrink_policy; }
+    void set_shrink_policy(const ShrinkPolicy& shrink_policy_) {
+        shrink_policy = shrink_policy_;
+        shrink_if_sparse();
+    }
+
+    // Caps the content at size_limit_ elements, or lifts the cap when it is
+    // 0. Under a cap, an edit that grows the content past it drops elements
+    // from the front, which observers see through trimming and trimmed, as for
+    // the scrollback of a terminal or a tailed log. The storage that dropped
+    // elements leave in front of the content is reused before the storage
+    // grows, so that appending and dropping cost amortized O(1) per element
+    // instead of moving the content for every drop.
+    size_type get_size_limit() const { return size_limit; }
+    void set_size_limit(size_type size_limit_) {
+        if (size_limit_ < 0) {
+            throw std::out_of_range("Invalid size limit");
+        }
+        size_limit = size_limit_;
+        trim_to_size_limit();
+    }
+
+    // Observers are not owned and must be removed before they are destroyed.
+    // They follow the content when the buffer is moved or swapped.
+    void add_observer(observer_type* observer) {
+        observers.push_back(observer);
+        observer->reset(csegments());
+    }
+
+    void remove_observer(observer_type* observer) {
+        observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+    }
+
+    // Returns a snapshot of the content without copying it. The first
+    // modification after a snapshot is taken copies the storage if the
+    // snapshot is still alive, and takes the storage back otherwise. With a
+    // stateful allocator the last snapshot to be released frees the storage
+    // on its own thread, so the allocator must then be thread safe.
+    snapshot_type snapshot() {
+        if (buffer == nullptr) {
+            return snapshot_type{};
+        }
+        if (!shared_storage) {
+            shared_storage = std::make_shared<SharedStorage>(allocator, buffer, buffer_size, front_size, gap_position,
+                gap_size);
+        }
+        return snapshot_type{shared_storage, buffer, buffer_size, gap_position, gap_size};
+    }
+
+    // Replaces the content with count elements that fill writes in place,
+    // with a gap of gap_size_ elements at gap_position_. fill receives the
+    // writable segments before and after the gap and must write every
+    // element of both, which is why the elements must be trivially copyable.
+    // This lets loaders read straight into the storage.
+    template<typename Fill>
+    void assign_for_overwrite(size_type count, size_type gap_position_, size_type gap_size_, Fill fill) {
+        static_assert(std::is_trivially_copyable<Element>::value, "Elements must be trivially copyable");
+        if ((gap_position_ < 0) || (gap_position_ > count) || (gap_size_ < 0)) {
+            throw std::out_of_range("Invalid position");
+        }
+
+        deallocate();
+        const auto new_buffer_size = count + gap_size_;
+        if (new_buffer_size > 0) {
+            buffer = AllocatorTraits::allocate(allocator, new_buffer_size);
+            buffer_size = new_buffer_size;
+            gap_position = gap_position_;
+            gap_size = gap_size_;
+            instrumentation.reallocated(new_buffer_size, 0);
+            try {
+                fill(segments());
+            } catch (...) {
+                deallocate();
+                reset_observers();
+                throw;
+            }
+        }
+        reset_observers();
+        trim_to_size_limit();
+    }
+
+    template<typename ElementRange>
+    void insert(ElementRange insert_range, size_type position) {
+        EditTimer edit_timer{instrumentation};
+        insert_elements(insert_range, position);
+        trim_to_size_limit();
     }
 
     template<typename ElementRange>
@@ -162,12 +440,72 @@ public:
         insert(append_range, size());
     }
 
-    void remove(size_type position, size_type count) {
+    // Inserts the elements of insert_range by moving them, which leaves the
+    // source elements in a moved from state.
+    template<typename ElementRange>
+    void move_insert(ElementRange insert_range, size_type position) {
+        insert(make_range(std::make_move_iterator(insert_range.begin()), std::make_move_iterator(insert_range.end())),
+            position);
+    }
+
+    // Constructs an element from arguments directly in the gap at position.
+    // As with insert, the arguments must not refer to elements of the buffer,
+    // which moving the gap can move.
+    template<typename... Arguments>
+    void emplace(size_type position, Arguments&&... arguments) {
+        EditTimer edit_timer{instrumentation};
         validate_position(position);
-        validate_position(position + count);
+        move_gap(position);
+        expand_gap(1);
+        construct_at_gap(1, [&](Element* destination) {
+            AllocatorTraits::construct(allocator, destination, std::forward<Arguments>(arguments)...);
+        });
+        trim_to_size_limit();
+    }
+
+    void insert_at(size_type position, const Element& element) {
+        emplace(position, element);
+    }
 
+    void insert_at(size_type position, Element&& element) {
+        emplace(position, std::move(element));
+    }
+
+    // Inserts count elements at position that construct_element constructs
+    // in the uninitialized storage of the gap, for elements that are built
+    // from some other representation and would otherwise be constructed
+    // once and then copied. construct_element receives a pointer to the
+    // storage and the index of the element, and must construct exactly one
+    // element there, with placement new or the allocator. If it throws, the
+    // elements constructed so far are destroyed and the content is left as
+    // it was.
+    template<typename ConstructElement>
+    void insert_in_place(size_type position, size_type count, ConstructElement construct_element) {
+        EditTimer edit_timer{instrumentation};
+        validate_position(position);
+        if (count < 0) {
+            throw std::out_of_range("Invalid count");
+        }
         move_gap(position);
-        gap_size += count;
+        expand_gap(count);
+        construct_at_gap(count, [this, count, &construct_element](Element* destination) {
+            auto constructed = destination;
+            try {
+                for (size_type index = 0; index < count; ++index, ++constructed) {
+                    construct_element(constructed, index);
+                }
+            } catch (...) {
+                destroy(destination, constructed);
+                throw;
+            }
+        });
+        trim_to_size_limit();
+    }
+
+    void remove(size_type position, size_type count) {
+        EditTimer edit_timer{instrumentation};
+        remove_elements(position, count);
+        shrink_if_sparse();
     }
 
     void remove(const_range remove_range) {
@@ -178,8 +516,11 @@ public:
 
     template<typename ElementRange>
     void replace(size_type position, size_type count, ElementRange insert_range) {
-        remove(position, count);
-        insert(insert_range, position);
+        EditTimer edit_timer{instrumentation};
+        remove_elements(position, count);
+        insert_elements(insert_range, position);
+        trim_to_size_limit();
+        shrink_if_sparse();
     }
 
     template<typename ElementRange>
@@ -189,27 +530,255 @@ public:
         replace(position, count, insert_range);
     }
 
+    // Moves the count elements of source at source_position to position,
+    // removing them from source. The gap of this buffer is moved to position
+    // and the elements are relocated straight from the storage of source, a
+    // memcpy per side of its gap for trivially copyable elements, so they
+    // are neither copied out to a temporary nor copied twice. When this
+    // buffer is empty and the whole of source is moved, the storage of
+    // source is taken over instead. Observers of both buffers are notified,
+    // and source must be another buffer.
+    void splice(size_type position, GapBuffer& source, size_type source_position, size_type count) {
+        EditTimer edit_timer{instrumentation};
+        if (&source == this) {
+            throw std::invalid_argument("Cannot splice a buffer into itself");
+        }
+        validate_position(position);
+        if ((source_position < 0) || (count < 0) || ((source_position + count) > source.size())) {
+            throw std::out_of_range("Invalid position");
+        }
+        if (count == 0) {
+            return;
+        }
+
+        if ((size() == 0) && (count == source.size()) && (allocator == source.allocator)) {
+            source.notify_removing(0, count);
+            deallocate();
+            steal_buffer(source);
+            instrumentation.inserted(count);
+            source.instrumentation.removed(count);
+            for (auto observer : source.observers) {
+                observer->removed(source.csegments(), 0, count);
+            }
+            for (auto observer : observers) {
+                observer->inserted(csegments(), 0, count);
+            }
+            trim_to_size_limit();
+            return;
+        }
+
+        source.detach();
+        move_gap(position);
+        expand_gap(count);
+        const auto before_gap_count = std::max(std::min(source_position + count, source.gap_position) - source_position,
+            static_cast<size_type>(0));
+        const auto before_gap_first = source.buffer_begin() + source_position;
+        const auto after_gap_first = source.buffer_begin() + source.to_buffer_position(source_position + before_gap_count);
+        // The observers of source see the elements before they are moved out.
+        source.notify_removing(source_position, count);
+        construct_at_gap(count, [&](Element* destination) {
+            relocate_from(before_gap_first, before_gap_first + before_gap_count, destination);
+            try {
+                relocate_from(after_gap_first, after_gap_first + (count - before_gap_count), destination + before_gap_count);
+            } catch (...) {
+                destroy(destination, destination + before_gap_count);
+                throw;
+            }
+        });
+        source.erase_elements(source_position, count);
+        source.shrink_if_sparse();
+        trim_to_size_limit();
+    }
+
+    void splice(size_type position, GapBuffer& source, const_range source_range) {
+        const auto source_position = std::distance(source.cbegin(), source_range.begin());
+        splice(position, source, source_position, std::distance(source_range.begin(), source_range.end()));
+    }
+
+    void splice(size_type position, GapBuffer& source) {
+        splice(position, source, 0, source.size());
+    }
+
+    // Applies a batch of edits that do not overlap in one sweep over the
+    // content, from the end of the edits nearest to the gap to the other, so
+    // that the gap only moves one way and the content between the edits is
+    // moved at most once. The storage grows at most once, and observers are
+    // notified of every edit. Returns the position of each edit in the new
+    // content, in the order of edits. Edits at the same position are applied
+    // in the order of edits.
+    template<typename EditRange>
+    std::vector<size_type> apply_edits(const EditRange& edits) {
+        EditTimer edit_timer{instrumentation};
+        using std::begin;
+        using std::end;
+        const auto first_edit = begin(edits);
+        const auto last_edit = end(edits);
+        const auto is_before = [](const auto& lhs, const auto& rhs) {
+            return lhs.position < rhs.position;
+        };
+        // Edits are usually given in order already, in which case the order
+        // is left empty rather than filled with every index.
+        std::vector<size_type> order;
+        if (!std::is_sorted(first_edit, last_edit, is_before)) {
+            order.resize(std::distance(first_edit, last_edit));
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [first_edit, is_before](size_type lhs, size_type rhs) {
+                return is_before(first_edit[lhs], first_edit[rhs]);
+            });
+        }
+        const auto edit_index = [&order](size_type rank) {
+            return order.empty() ? rank : order[rank];
+        };
+
+        const auto edit_count = static_cast<size_type>(std::distance(first_edit, last_edit));
+        std::vector<size_type> positions(edit_count);
+        size_type previous_end = 0;
+        size_type growth = 0;
+        size_type max_growth = 0;
+        for (size_type rank = 0; rank < edit_count; ++rank) {
+            const auto index = edit_index(rank);
+            const auto& edit = first_edit[index];
+            if ((edit.position < previous_end) || (edit.count < 0) || ((edit.position + edit.count) > size())) {
+                throw std::out_of_range("Invalid or overlapping edit");
+            }
+            previous_end = edit.position + edit.count;
+            positions[index] = edit.position + growth;
+            growth += edit.insert_range.size() - edit.count;
+            max_growth = std::max(max_growth, growth);
+        }
+        if (edit_count == 0) {
+            return positions;
+        }
+
+        const auto sweep_begin = first_edit[edit_index(0)].position;
+        const auto sweep_end = previous_end;
+        if (std::abs(gap_position - sweep_begin) <= std::abs(gap_position - sweep_end)) {
+            expand_gap(max_growth);
+            for (size_type rank = 0; rank < edit_count; ++rank) {
+                const auto index = edit_index(rank);
+                const auto& edit = first_edit[index];
+                remove_valid_elements(positions[index], edit.count);
+                insert_at_gap(edit.insert_range);
+            }
+        } else {
+            // Edits applied from the last one keep their original positions.
+            size_type suffix_growth = 0;
+            size_type max_suffix_growth = 0;
+            for (auto rank = edit_count - 1; rank >= 0; --rank) {
+                const auto& edit = first_edit[edit_index(rank)];
+                suffix_growth += edit.insert_range.size() - edit.count;
+                max_suffix_growth = std::max(max_suffix_growth, suffix_growth);
+            }
+            expand_gap(max_suffix_growth);
+            for (auto rank = edit_count - 1; rank >= 0; --rank) {
+                const auto& edit = first_edit[edit_index(rank)];
+                remove_valid_elements(edit.position, edit.count);
+                insert_at_gap(edit.insert_range);
+            }
+        }
+        trim_to_size_limit();
+        shrink_if_sparse();
+        return positions;
+    }
+
+    void clear() {
+        remove(0, size());
+    }
+
+    // Grows the storage so that at least new_capacity elements fit without
+    // a further reallocation.
+    void reserve(size_type new_capacity) {
+        if (new_capacity > buffer_size) {
+            reallocate(new_capacity);
+        }
+    }
+
+    // Releases the gap and the storage that the size limit left in front of
+    // the content, leaving storage for exactly size() elements.
+    void shrink_to_fit() {
+        if (size() == 0) {
+            deallocate();
+        } else if ((gap_size > 0) || (front_size > 0)) {
+            reallocate(size());
+        }
+    }
+
     size_type size() const { return buffer_size - gap_size; }
+    size_type capacity() const { return buffer_size; }
 
     iterator begin() {
-        auto position = (gap_position == 0) ? gap_size : 0;
-        return iterator(buffer.get(), position, buffer_size, gap_position, gap_size);
+        detach();
+        return make_iterator<iterator>(buffer_begin() + ((gap_position == 0) ? gap_size : 0));
     }
     iterator end() {
-        return iterator(buffer.get(), buffer_size, buffer_size, gap_position, gap_size);
+        detach();
+        return make_iterator<iterator>(buffer_end());
     }
 
     const_iterator begin() const {
-        auto position = (gap_position == 0) ? gap_size : 0;
-        return const_iterator(buffer.get(), position, buffer_size, gap_position, gap_size);
+        return make_iterator<const_iterator>(buffer_begin() + ((gap_position == 0) ? gap_size : 0));
     }
     const_iterator end() const {
-        return const_iterator(buffer.get(), buffer_size, buffer_size, gap_position, gap_size);
+        return make_iterator<const_iterator>(buffer_end());
     }
 
     const_iterator cbegin() const { return begin(); }
     const_iterator cend() const { return end(); }
 
+    Segments<Element> segments() {
+        return Segments<Element>{before_gap(), after_gap()};
+    }
+    Segments<const Element> segments() const {
+        return Segments<const Element>{before_gap(), after_gap()};
+    }
+    Segments<const Element> csegments() const { return segments(); }
+
+    Range<Element*> before_gap() {
+        detach();
+        return make_range(buffer_begin(), buffer_begin() + gap_position);
+    }
+    Range<Element*> after_gap() {
+        detach();
+        return make_range(buffer_begin() + gap_position + gap_size, buffer_end());
+    }
+
+    Range<const Element*> before_gap() const {
+        return make_range(buffer_begin(), buffer_begin() + gap_position);
+    }
+    Range<const Element*> after_gap() const {
+        return make_range(buffer_begin() + gap_position + gap_size, buffer_end());
+    }
+
+    // Returns the count elements at position as contiguous memory, for code
+    // that wants a pointer and a size. A range on one side of the gap is
+    // returned in place, and policy decides how a range across the gap is
+    // made contiguous. The view is valid until the buffer is next modified
+    // or viewed.
+    Range<const Element*> view(size_type position, size_type count, ViewPolicy policy = ViewPolicy::move_gap) {
+        if ((position < 0) || (count < 0) || ((position + count) > size())) {
+            throw std::out_of_range("Invalid position");
+        }
+        const auto end_position = position + count;
+        if ((end_position > gap_position) && (position < gap_position)) {
+            if (policy == ViewPolicy::copy) {
+                view_scratch.assign(buffer_begin() + position, buffer_begin() + gap_position);
+                const auto after_gap_begin = buffer_begin() + gap_position + gap_size;
+                view_scratch.insert(view_scratch.end(), after_gap_begin, after_gap_begin + (end_position - gap_position));
+                const Element* scratch = view_scratch.data();
+                return make_range(scratch, scratch + count);
+            }
+            move_gap(((gap_position - position) < (end_position - gap_position)) ? position : end_position);
+        }
+        const Element* first = buffer_begin() + to_buffer_position(position);
+        return make_range(first, first + count);
+    }
+
+    // Moves the gap to whichever end of the content is nearer, so that the
+    // whole content is contiguous.
+    Range<const Element*> linearize() {
+        return view(0, size());
+    }
+
 private:
 
     bool is_valid_position(size_type position) {
@@ -222,7 +791,7 @@ private:
         }
     }
 
-    size_type to_buffer_position(size_type position) {
+    size_type to_buffer_position(size_type position) const {
         if (position < gap_position) {
             return position;
         } else {
@@ -230,67 +799,493 @@ private:
         }
     }
 
-    const Element* buffer_begin() const { return buffer.get(); }
-    const Element* buffer_end() const { buffer_begin() + buffer_size; }
+    const Element* buffer_begin() const { return buffer; }
+    const Element* buffer_end() const { return buffer_begin() + buffer_size; }
 
-    Element* buffer_begin() { return buffer.get(); }
+    Element* buffer_begin() { return buffer; }
     Element* buffer_end() { return buffer_begin() + buffer_size; }
 
+    template<typename Iterator>
+    Iterator make_iterator(typename Iterator::pointer element) const {
+#if CURSOR_CHECKED_ITERATORS
+        return Iterator(element, buffer + gap_position, buffer + gap_position + gap_size, &iterator_version);
+#else
+        return Iterator(element, buffer + gap_position, buffer + gap_position + gap_size);
+#endif
+    }
+
+    // Called by every change to the storage or the gap, which moves elements
+    // or the gap under the iterators.
+    void invalidate_iterators() {
+#if CURSOR_CHECKED_ITERATORS
+        iterator_version += 1;
+#endif
+    }
+
+    using AllocatorTraits = std::allocator_traits<allocator_type>;
+    using IsTriviallyCopyable = std::is_trivially_copyable<Element>;
+
+    template<typename InputIterator>
+    void construct(InputIterator first, InputIterator last, Element* destination) {
+        auto constructed = destination;
+        try {
+            for (; first != last; ++first, ++constructed) {
+                AllocatorTraits::construct(allocator, constructed, *first);
+            }
+        } catch (...) {
+            destroy(destination, constructed);
+            throw;
+        }
+    }
+
+    void destroy(Element* first, Element* last) {
+        for (auto element = first; element != last; ++element) {
+            AllocatorTraits::destroy(allocator, element);
+        }
+    }
+
+    void deallocate() {
+        if (buffer == nullptr) {
+            return;
+        }
+        if (shared_storage) {
+            shared_storage.reset();
+        } else {
+            destroy(buffer_begin(), buffer_begin() + gap_position);
+            destroy(buffer_begin() + gap_position + gap_size, buffer_end());
+            AllocatorTraits::deallocate(allocator, buffer - front_size, buffer_size + front_size);
+        }
+        front_size = 0;
+        buffer = nullptr;
+        buffer_size = 0;
+        gap_position = 0;
+        gap_size = 0;
+        invalidate_iterators();
+    }
+
+    void steal_buffer(GapBuffer& other) {
+        shared_storage = std::move(other.shared_storage);
+        front_size = other.front_size;
+        buffer = other.buffer;
+        buffer_size = other.buffer_size;
+        gap_position = other.gap_position;
+        gap_size = other.gap_size;
+        other.front_size = 0;
+        other.buffer = nullptr;
+        other.buffer_size = 0;
+        other.gap_position = 0;
+        other.gap_size = 0;
+        invalidate_iterators();
+        other.invalidate_iterators();
+    }
+
+    void move_assign(GapBuffer& other, std::true_type) {
+        deallocate();
+        allocator = std::move(other.allocator);
+        growth_policy = std::move(other.growth_policy);
+        shrink_policy = other.shrink_policy;
+        observers = std::move(other.observers);
+        instrumentation = std::move(other.instrumentation);
+        size_limit = other.size_limit;
+        view_scratch = std::move(other.view_scratch);
+        steal_buffer(other);
+    }
+
+    void move_assign(GapBuffer& other, std::false_type) {
+        growth_policy = std::move(other.growth_policy);
+        shrink_policy = other.shrink_policy;
+        instrumentation = std::move(other.instrumentation);
+        size_limit = other.size_limit;
+        observers.clear();
+        if (allocator == other.allocator) {
+            deallocate();
+            steal_buffer(other);
+            observers = std::move(other.observers);
+            return;
+        }
+
+        clear();
+        other.detach();
+        expand_gap(other.size());
+        auto destination = buffer_begin();
+        for (auto segment : {other.before_gap(), other.after_gap()}) {
+            construct(std::make_move_iterator(segment.begin()), std::make_move_iterator(segment.end()), destination);
+            destination += segment.size();
+            gap_position += segment.size();
+            gap_size -= segment.size();
+        }
+        observers = std::move(other.observers);
+        other.clear();
+    }
+
+    void swap_allocator(GapBuffer& other, std::true_type) {
+        using std::swap;
+        swap(allocator, other.allocator);
+    }
+
+    void swap_allocator(GapBuffer& other, std::false_type) {
+        assert(allocator == other.allocator);
+    }
+
+    // Moves [first, last) to the possibly overlapping range starting at
+    // destination, leaving the source uninitialized. The destination must not
+    // hold constructed elements outside of the source range.
+    void relocate(Element* first, Element* last, Element* destination) {
+        relocate(first, last, destination, IsTriviallyCopyable{});
+    }
+
+    void relocate(Element* first, Element* last, Element* destination, std::true_type) {
+        if ((first != last) && (destination != first)) {
+            std::memmove(destination, first, (last - first) * sizeof(Element));
+        }
+    }
+
+    void relocate(Element* first, Element* last, Element* destination, std::false_type) {
+        if (destination == first) {
+            return;
+        } else if (destination < first) {
+            for (auto element = first; element != last; ++element, ++destination) {
+                AllocatorTraits::construct(allocator, destination, std::move(*element));
+                AllocatorTraits::destroy(allocator, element);
+            }
+        } else {
+            auto destination_last = destination + (last - first);
+            for (auto element = last; element != first;) {
+                --element;
+                --destination_last;
+                AllocatorTraits::construct(allocator, destination_last, std::move(*element));
+                AllocatorTraits::destroy(allocator, element);
+            }
+        }
+    }
+
+    template<typename ElementRange>
+    void insert_elements(ElementRange insert_range, size_type position) {
+        validate_position(position);
+
+        move_gap(position);
+        expand_gap(insert_range.size());
+        insert_at_gap(insert_range);
+    }
+
+    // Constructs the elements of [first, last) at destination by moving
+    // them, leaving the source elements to be destroyed by their owner.
+    void relocate_from(Element* first, Element* last, Element* destination) {
+        relocate_from(first, last, destination, IsTriviallyCopyable{});
+    }
+
+    void relocate_from(Element* first, Element* last, Element* destination, std::true_type) {
+        if (first != last) {
+            std::memcpy(destination, first, (last - first) * sizeof(Element));
+        }
+    }
+
+    void relocate_from(Element* first, Element* last, Element* destination, std::false_type) {
+        construct(std::make_move_iterator(first), std::make_move_iterator(last), destination);
+    }
+
+    void remove_elements(size_type position, size_type count) {
+        validate_position(position);
+        validate_position(position + count);
+        remove_valid_elements(position, count);
+    }
+
+    void remove_valid_elements(size_type position, size_type count) {
+        detach();
+        notify_removing(position, count);
+        erase_elements(position, count);
+    }
+
+    void notify_removing(size_type position, size_type count) {
+        for (auto observer : observers) {
+            observer->removing(csegments(), position, count);
+        }
+    }
+
+    // Destroys the count elements at position, which observers have been
+    // told are being removed.
+    void erase_elements(size_type position, size_type count) {
+        move_gap(position);
+        auto gap_end = buffer_begin() + gap_position + gap_size;
+        destroy(gap_end, gap_end + count);
+        gap_size += count;
+        invalidate_iterators();
+        instrumentation.removed(count);
+
+        for (auto observer : observers) {
+            observer->removed(csegments(), position, count);
+        }
+    }
+
+    // Inserts at the gap, which must be large enough for insert_range.
+    template<typename ElementRange>
+    void insert_at_gap(const ElementRange& insert_range) {
+        construct_at_gap(insert_range.size(), [this, &insert_range](Element* destination) {
+            construct(insert_range.begin(), insert_range.end(), destination);
+        });
+    }
+
+    // Adds count elements at the gap, which must be large enough for them,
+    // after construct_elements has constructed them at the start of the gap.
+    template<typename ConstructElements>
+    void construct_at_gap(size_type count, ConstructElements construct_elements) {
+        detach();
+        const auto position = gap_position;
+        construct_elements(buffer_begin() + gap_position);
+
+        gap_position += count;
+        gap_size -= count;
+        invalidate_iterators();
+        instrumentation.inserted(count);
+
+        for (auto observer : observers) {
+            observer->inserted(csegments(), position, count);
+        }
+    }
+
+    // Reports the time of a public edit to the instrumentation when it goes
+    // out of scope.
+    class EditTimer {
+    public:
+        explicit EditTimer(Instrumentation& instrumentation_)
+            : instrumentation{instrumentation_}, start{instrumentation_.start_edit()} {}
+
+        EditTimer(const EditTimer&) = delete;
+        EditTimer& operator=(const EditTimer&) = delete;
+
+        ~EditTimer() {
+            instrumentation.finish_edit(start);
+        }
+
+    private:
+        Instrumentation& instrumentation;
+        decltype(std::declval<Instrumentation&>().start_edit()) start;
+    };
+
+    void reset_observers() {
+        for (auto observer : observers) {
+            observer->reset(csegments());
+        }
+    }
+
+    // Storage handed over to snapshots. The buffer keeps using it until it is
+    // modified, and then either takes it back or leaves it to the snapshots.
+    struct SharedStorage {
+        SharedStorage(const allocator_type& allocator_, Element* buffer_, size_type buffer_size_,
+            size_type front_size_, size_type gap_position_, size_type gap_size_)
+            : allocator{allocator_}, buffer{buffer_}, buffer_size{buffer_size_}, front_size{front_size_},
+              gap_position{gap_position_}, gap_size{gap_size_} {}
+
+        SharedStorage(const SharedStorage&) = delete;
+        SharedStorage& operator=(const SharedStorage&) = delete;
+
+        ~SharedStorage() {
+            if (buffer == nullptr) {
+                return;
+            }
+            for (auto element = buffer; element != (buffer + gap_position); ++element) {
+                AllocatorTraits::destroy(allocator, element);
+            }
+            for (auto element = buffer + gap_position + gap_size; element != (buffer + buffer_size); ++element) {
+                AllocatorTraits::destroy(allocator, element);
+            }
+            AllocatorTraits::deallocate(allocator, buffer - front_size, buffer_size + front_size);
+        }
+
+        allocator_type allocator;
+        Element* buffer;
+        size_type buffer_size;
+        size_type front_size;
+        size_type gap_position;
+        size_type gap_size;
+    };
+
+    // Makes the storage exclusive to the buffer before it is modified.
+    void detach() {
+        if (!shared_storage) {
+            return;
+        }
+        if (shared_storage.use_count() == 1) {
+            // Pairs with the release of the last snapshot, so that its reads
+            // happen before the buffer writes to the storage again.
+            std::atomic_thread_fence(std::memory_order_acquire);
+            shared_storage->buffer = nullptr;
+            shared_storage.reset();
+            return;
+        }
+
+        auto new_buffer = AllocatorTraits::allocate(allocator, buffer_size);
+        const auto after_gap_begin = gap_position + gap_size;
+        try {
+            construct(buffer_begin(), buffer_begin() + gap_position, new_buffer);
+            try {
+                construct(buffer_begin() + after_gap_begin, buffer_end(), new_buffer + after_gap_begin);
+            } catch (...) {
+                destroy(new_buffer, new_buffer + gap_position);
+                throw;
+            }
+        } catch (...) {
+            AllocatorTraits::deallocate(allocator, new_buffer, buffer_size);
+            throw;
+        }
+        buffer = new_buffer;
+        front_size = 0;
+        shared_storage.reset();
+        invalidate_iterators();
+    }
+
+    void shrink_if_sparse() {
+        if (!shrink_policy.should_shrink(buffer_size, size())) {
+            return;
+        }
+        if (size() == 0) {
+            deallocate();
+        } else {
+            reallocate(std::max(shrink_policy.new_buffer_size(size()), size()));
+        }
+    }
+
     void move_gap(size_type new_gap_position) {
         if (gap_position == new_gap_position) {
             return;
         }
 
+        detach();
         auto gap_begin = buffer_begin() + gap_position;
         auto gap_end = gap_begin + gap_size;
         auto new_gap_begin = buffer_begin() + new_gap_position;
         auto new_gap_end = new_gap_begin + gap_size;
 
         if (new_gap_position < gap_position) {
-            std::copy(new_gap_begin, gap_begin, new_gap_end);
+            relocate(new_gap_begin, gap_begin, new_gap_end);
         } else {
-            std::copy(gap_end, new_gap_end, gap_begin);
+            relocate(gap_end, new_gap_end, gap_begin);
         }
 
+        const auto distance = std::abs(new_gap_position - gap_position);
+        instrumentation.gap_moved(distance, distance * sizeof(Element));
         gap_position = new_gap_position;
+        invalidate_iterators();
     }
 
     void expand_gap(size_type min_gap_size) {
         if (gap_size >= min_gap_size) {
             return;
         }
-
-        const auto min_buffer_size = (buffer_size - gap_size) + min_gap_size;
-        auto new_buffer_size = std::max(buffer_size, static_cast<decltype(buffer_size)>(1));
-        while (new_buffer_size <= min_buffer_size) {
-            new_buffer_size *= 2;
+        // The storage in front of the content is taken back by moving the
+        // elements before the gap onto it once it is at least as large as the
+        // content, so that each move is paid for by as many appended elements.
+        if ((front_size > 0) && ((front_size + gap_size) >= std::max(min_gap_size, size()))) {
+            detach();
+            reclaim_front();
+            if (gap_size >= min_gap_size) {
+                return;
+            }
         }
+
+        const auto content_size = buffer_size - gap_size;
+        const auto min_buffer_size = content_size + min_gap_size;
+        const auto new_buffer_size = growth_policy.new_buffer_size(buffer_size, content_size, min_buffer_size);
+        assert(new_buffer_size >= min_buffer_size);
+        reallocate(new_buffer_size);
+    }
+
+    void reallocate(size_type new_buffer_size) {
+        detach();
         const auto new_gap_size = new_buffer_size - (buffer_size - gap_size);
+        assert(new_gap_size >= 0);
 
-        auto new_buffer = std::make_unique<Element[]>(new_buffer_size);
+        auto new_buffer = AllocatorTraits::allocate(allocator, new_buffer_size);
 
         auto buffer_end = buffer_begin() + buffer_size;
 
         auto gap_begin = buffer_begin() + gap_position;
         auto gap_end = gap_begin + gap_size;
 
-        auto new_buffer_begin = new_buffer.get();
+        auto new_buffer_begin = new_buffer;
 
         auto new_gap_begin = new_buffer_begin + gap_position;
         auto new_gap_end = new_gap_begin + new_gap_size;
 
-        std::copy(buffer_begin(), gap_begin, new_buffer_begin);
-        std::copy(gap_end, buffer_end, new_gap_end);
+        relocate(buffer_begin(), gap_begin, new_buffer_begin);
+        relocate(gap_end, buffer_end, new_gap_end);
 
-        buffer = std::move(new_buffer);
+        if (buffer != nullptr) {
+            AllocatorTraits::deallocate(allocator, buffer - front_size, buffer_size + front_size);
+        }
+        instrumentation.reallocated(new_buffer_size, (buffer_size - gap_size) * sizeof(Element));
+        front_size = 0;
+        buffer = new_buffer;
         buffer_size = new_buffer_size;
         gap_size = new_gap_size;
+        invalidate_iterators();
+    }
+
+    // Moves the elements before the gap to the start of the storage, which
+    // adds the storage in front of the content to the gap.
+    void reclaim_front() {
+        if (front_size == 0) {
+            return;
+        }
+        const auto storage = buffer - front_size;
+        relocate(buffer_begin(), buffer_begin() + gap_position, storage);
+        instrumentation.gap_moved(front_size, gap_position * sizeof(Element));
+        buffer = storage;
+        buffer_size += front_size;
+        gap_size += front_size;
+        front_size = 0;
+        invalidate_iterators();
+    }
+
+    // Drops elements from the front until the content fits the size limit.
+    // The storage of the dropped elements is left in front of the content
+    // rather than moving the content back over it.
+    void trim_to_size_limit() {
+        if ((size_limit == 0) || (size() <= size_limit)) {
+            return;
+        }
+        const auto count = size() - size_limit;
+        detach();
+        for (auto observer : observers) {
+            observer->trimming(csegments(), count);
+        }
+
+        if (gap_position < count) {
+            move_gap(count);
+        }
+        destroy(buffer_begin(), buffer_begin() + count);
+        buffer += count;
+        buffer_size -= count;
+        front_size += count;
+        gap_position -= count;
+        invalidate_iterators();
+        instrumentation.removed(count);
+
+        for (auto observer : observers) {
+            observer->trimmed(csegments(), count);
+        }
     }
 
-    Buffer buffer;
+    allocator_type allocator;
+    GrowthPolicy growth_policy;
+    ShrinkPolicy shrink_policy;
+    std::vector<observer_type*> observers;
+    Instrumentation instrumentation;
+    size_type size_limit = 0;
+    std::shared_ptr<SharedStorage> shared_storage;
+    // The storage in front of buffer that elements dropped by the size limit
+    // left behind.
+    size_type front_size = 0;
+    Element* buffer = nullptr;
     size_type buffer_size = 0;
     size_type gap_position = 0;
     size_type gap_size = 0;
+    // Made with the allocator of the buffer, which it follows when the
+    // allocator is moved or swapped.
+    std::vector<Element, allocator_type> view_scratch;
+#if CURSOR_CHECKED_ITERATORS
+    std::size_t iterator_version = 0;
+#endif
 };
 
 }
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+#include <cassert>
+
+namespace cursor {
+// A growth policy chooses the new buffer size when the gap is too small for
+// an insertion. new_buffer_size receives the current buffer size, the number
+// of elements outside of the gap and the smallest buffer size that can hold
+// the insertion, and must return a size of at least min_buffer_size.
+
+template<std::ptrdiff_t Numerator, std::ptrdiff_t Denominator>
+class GeometricGrowthPolicy {
+public:
+    static_assert(Numerator > Denominator, "Growth factor must be greater than one");
+    static_assert(Denominator > 0, "Growth factor denominator must be positive");
+
+    using size_type = std::ptrdiff_t;
+
+    size_type new_buffer_size(size_type buffer_size, size_type, size_type min_buffer_size) const {
+        auto new_buffer_size = std::max(buffer_size, static_cast<size_type>(1));
+        while (new_buffer_size <= min_buffer_size) {
+            new_buffer_size = std::max((new_buffer_size * Numerator) / Denominator, new_buffer_size + 1);
+        }
+        return new_buffer_size;
+    }
+};
+
+using DoublingGrowthPolicy = GeometricGrowthPolicy<2, 1>;
+using OneAndAHalfGrowthPolicy = GeometricGrowthPolicy<3, 2>;
+
+template<std::ptrdiff_t ChunkSize>
+class FixedChunkGrowthPolicy {
+public:
+    static_assert(ChunkSize > 0, "Chunk size must be positive");
+
+    using size_type = std::ptrdiff_t;
+
+    size_type new_buffer_size(size_type buffer_size, size_type, size_type min_buffer_size) const {
+        const auto chunk_count = (min_buffer_size / ChunkSize) + 1;
+        return std::max(buffer_size, chunk_count * ChunkSize);
+    }
+};
+
+// Sizes the new gap as a fraction of the content, so that large buffers do
+// not double their footprint on growth.
+template<std::ptrdiff_t Numerator, std::ptrdiff_t Denominator, std::ptrdiff_t MinGapSize = 64>
+class GapProportionalGrowthPolicy {
+public:
+    static_assert(Numerator > 0, "Gap fraction must be positive");
+    static_assert(Denominator > 0, "Gap fraction denominator must be positive");
+    static_assert(MinGapSize > 0, "Minimum gap size must be positive");
+
+    using size_type = std::ptrdiff_t;
+
+    size_type new_buffer_size(size_type buffer_size, size_type content_size, size_type min_buffer_size) const {
+        const auto gap_size = std::max((content_size * Numerator) / Denominator, MinGapSize);
+        return std::max(buffer_size, min_buffer_size + gap_size);
+    }
+};
+
+// A shrink policy releases memory after removals. Once the gap exceeds
+// max_gap_ratio times the content, the buffer is reallocated with a gap of
+// target_gap_ratio times the content. Keeping the target well below the
+// maximum provides hysteresis, so that alternating removals and insertions
+// do not reallocate on every edit. Buffers smaller than min_buffer_size are
+// never shrunk. A default constructed policy never shrinks.
+class ShrinkPolicy {
+public:
+    using size_type = std::ptrdiff_t;
+
+    ShrinkPolicy() {}
+
+    ShrinkPolicy(double max_gap_ratio_, double target_gap_ratio_, size_type min_buffer_size_ = 4096)
+        : is_enabled{true}, max_gap_ratio{max_gap_ratio_}, target_gap_ratio{target_gap_ratio_},
+          min_buffer_size{min_buffer_size_} {
+        assert(max_gap_ratio > target_gap_ratio);
+        assert(target_gap_ratio >= 0.0);
+    }
+
+    bool should_shrink(size_type buffer_size, size_type content_size) const {
+        if (!is_enabled || (buffer_size <= min_buffer_size)) {
+            return false;
+        }
+        const auto gap_size = buffer_size - content_size;
+        return gap_size > static_cast<size_type>(max_gap_ratio * content_size);
+    }
+
+    size_type new_buffer_size(size_type content_size) const {
+        const auto gap_size = static_cast<size_type>(target_gap_ratio * content_size);
+        return content_size + gap_size;
+    }
+
+private:
+    bool is_enabled = false;
+    double max_gap_ratio = 0.0;
+    double target_gap_ratio = 0.0;
+    size_type min_buffer_size = 0;
+};
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace cursor {
+// An instrumentation policy is told about the work a GapBuffer does, to find
+// out where the time of the edits goes when tuning the growth policy or the
+// chunk size. The buffer calls:
+//
+// - inserted and removed with the number of elements of each edit,
+// - gap_moved with the distance the gap moves and the bytes moved with it,
+// - reallocated with the new capacity and the bytes moved to the new storage,
+// - start_edit before a public edit, and finish_edit with what start_edit
+//   returned once the edit is done.
+//
+// NullInstrumentation, the default, does nothing, so that the calls compile
+// away.
+class NullInstrumentation {
+public:
+    using size_type = std::ptrdiff_t;
+
+    void inserted(size_type) {}
+    void removed(size_type) {}
+    void gap_moved(size_type, size_type) {}
+    void reallocated(size_type, size_type) {}
+
+    int start_edit() { return 0; }
+    void finish_edit(int) {}
+};
+
+// Counts values in buckets of powers of two. Bucket 0 holds 0, and bucket n
+// holds the values in [2^(n-1), 2^n).
+struct Log2Histogram {
+    static constexpr int bucket_count = 65;
+
+    static int bucket_of(std::uint64_t value) {
+        return (value == 0) ? 0 : (64 - __builtin_clzll(value));
+    }
+
+    // Returns the largest value that falls in bucket.
+    static std::uint64_t bucket_limit(int bucket) {
+        return (bucket == 0) ? 0 : ((bucket == 64) ? UINT64_MAX : ((std::uint64_t{1} << bucket) - 1));
+    }
+
+    void add(std::uint64_t value) {
+        counts[bucket_of(value)] += 1;
+    }
+
+    std::uint64_t total() const {
+        std::uint64_t total_count = 0;
+        for (const auto count : counts) {
+            total_count += count;
+        }
+        return total_count;
+    }
+
+    // Returns a bound on the values below the given fraction of the values,
+    // which is the limit of the bucket that holds the value at that
+    // fraction, or 0 if there are no values.
+    std::uint64_t quantile_limit(double fraction) const {
+        const auto total_count = total();
+        const auto rank = std::max(static_cast<std::uint64_t>(std::ceil(fraction * total_count)), std::uint64_t{1});
+        std::uint64_t count = 0;
+        for (auto bucket = 0; bucket < bucket_count; ++bucket) {
+            count += counts[bucket];
+            if (count >= rank) {
+                return bucket_limit(bucket);
+            }
+        }
+        return 0;
+    }
+
+    std::array<std::uint64_t, bucket_count> counts{};
+};
+
+// The counters of a CountingInstrumentation at one point in time. Bytes moved
+// count the bytes that gap moves and reallocations relocate, and latencies
+// are in nanoseconds.
+struct InstrumentationSnapshot {
+    std::uint64_t insertions = 0;
+    std::uint64_t removals = 0;
+    std::uint64_t gap_moves = 0;
+    std::uint64_t bytes_moved = 0;
+    std::uint64_t reallocations = 0;
+    std::ptrdiff_t peak_capacity = 0;
+    Log2Histogram gap_move_distances;
+    Log2Histogram edit_latencies;
+};
+
+// Counts the work of the buffer it instruments and keeps histograms of the
+// gap move distances and of the edit latencies. Reading the clock costs more
+// than a typical edit, so only one edit in every latency_sample_period is
+// timed. Like the buffer it is not thread safe, so a snapshot is taken on the
+// thread that edits the buffer.
+class CountingInstrumentation {
+public:
+    using size_type = std::ptrdiff_t;
+    using clock = std::chrono::steady_clock;
+
+    explicit CountingInstrumentation(std::uint64_t latency_sample_period_ = 16)
+        : latency_sample_period{std::max(latency_sample_period_, std::uint64_t{1})} {}
+
+    void inserted(size_type) {
+        counters.insertions += 1;
+    }
+
+    void removed(size_type) {
+        counters.removals += 1;
+    }
+
+    void gap_moved(size_type distance, size_type bytes_moved) {
+        counters.gap_moves += 1;
+        counters.bytes_moved += bytes_moved;
+        counters.gap_move_distances.add(distance);
+    }
+
+    void reallocated(size_type capacity, size_type bytes_moved) {
+        counters.reallocations += 1;
+        counters.bytes_moved += bytes_moved;
+        if (capacity > counters.peak_capacity) {
+            counters.peak_capacity = capacity;
+        }
+    }
+
+    clock::time_point start_edit() {
+        edit_count += 1;
+        return ((edit_count % latency_sample_period) == 0) ? clock::now() : clock::time_point{};
+    }
+
+    void finish_edit(clock::time_point start) {
+        if (start == clock::time_point{}) {
+            return;
+        }
+        const auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start);
+        counters.edit_latencies.add(latency.count());
+    }
+
+    InstrumentationSnapshot snapshot() const {
+        return counters;
+    }
+
+    void reset() {
+        counters = InstrumentationSnapshot{};
+        edit_count = 0;
+    }
+
+private:
+    InstrumentationSnapshot counters;
+    std::uint64_t latency_sample_period;
+    std::uint64_t edit_count = 0;
+};
+
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "gap-buffer.hh"
+#include "segmented-algorithm.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace cursor {
+// Tracks the positions of the newlines in a GapBuffer it observes, so that
+// lines and offsets can be converted without walking the content.
+//
+// Like the buffer itself the index keeps a gap, placed at the position of the
+// most recent edit. Newlines before the gap are stored as offsets from the
+// start of the content, newlines after the gap as distances from the end of
+// the content, nearest to the gap last. Edits at the gap then only push or
+// pop the affected newlines, and moving the gap only converts the newlines
+// it passes over. Newlines before the gap are stored offset by the number
+// of elements removed from the front, and the first dropped_count of them
+// are dropped, so that dropping the front of the content, as a buffer with
+// a size limit does, only touches the newlines it drops.
+template<typename Element>
+class LineIndex : public GapBufferObserver<Element> {
+public:
+    using size_type = std::ptrdiff_t;
+
+    explicit LineIndex(Element newline_ = Element('\n')) : newline{newline_} {}
+
+    void reset(const Segments<const Element>& content) override {
+        before_gap.clear();
+        after_gap.clear();
+        origin = 0;
+        dropped_count = 0;
+        content_size = segmented::size(content);
+        push_newlines(content, 0, content_size);
+    }
+
+    void inserted(const Segments<const Element>& content, size_type position, size_type count) override {
+        move_gap(position);
+        content_size += count;
+        push_newlines(content, position, position + count);
+    }
+
+    void removing(const Segments<const Element>&, size_type position, size_type count) override {
+        if (position == 0) {
+            remove_front(count);
+            return;
+        }
+        move_gap(position);
+        while (!after_gap.empty() && (to_offset(after_gap.back()) < (position + count))) {
+            after_gap.pop_back();
+        }
+        content_size -= count;
+    }
+
+    size_type line_count() const {
+        return newline_count() + 1;
+    }
+
+    // Returns the offset of the first element of line.
+    size_type line_to_offset(size_type line) const {
+        if ((line < 0) || (line >= line_count())) {
+            throw std::out_of_range("Invalid line");
+        }
+        return (line == 0) ? 0 : (newline_offset(line - 1) + 1);
+    }
+
+    // Returns the line that contains the element at offset. The offset one
+    // past the end of the content belongs to the last line.
+    size_type offset_to_line(size_type offset) const {
+        if ((offset < 0) || (offset > content_size)) {
+            throw std::out_of_range("Invalid offset");
+        }
+        const auto before_gap_begin = before_gap.begin() + dropped_count;
+        const auto before_gap_count = std::lower_bound(before_gap_begin, before_gap.end(), offset + origin)
+            - before_gap_begin;
+        const auto after_gap_count = after_gap.end() - std::upper_bound(after_gap.begin(), after_gap.end(), content_size - offset);
+        return before_gap_count + after_gap_count;
+    }
+
+private:
+    size_type before_gap_size() const {
+        return static_cast<size_type>(before_gap.size()) - dropped_count;
+    }
+
+    size_type newline_count() const {
+        return before_gap_size() + after_gap.size();
+    }
+
+    size_type newline_offset(size_type newline_index) const {
+        const auto before_gap_count = before_gap_size();
+        if (newline_index < before_gap_count) {
+            return before_gap[dropped_count + newline_index] - origin;
+        }
+        return to_offset(after_gap[after_gap.size() - 1 - (newline_index - before_gap_count)]);
+    }
+
+    size_type to_offset(size_type distance_from_end) const {
+        return content_size - distance_from_end;
+    }
+
+    size_type to_distance_from_end(size_type offset) const {
+        return content_size - offset;
+    }
+
+    void move_gap(size_type position) {
+        while ((before_gap_size() > 0) && ((before_gap.back() - origin) >= position)) {
+            after_gap.push_back(to_distance_from_end(before_gap.back() - origin));
+            before_gap.pop_back();
+        }
+        while (!after_gap.empty() && (to_offset(after_gap.back()) < position)) {
+            before_gap.push_back(to_offset(after_gap.back()) + origin);
+            after_gap.pop_back();
+        }
+    }
+
+    // Drops the newlines of the first count elements without moving the
+    // gap, which only shifts the newlines before the gap by moving origin.
+    // The dropped newlines are erased once they are half of those before the
+    // gap.
+    void remove_front(size_type count) {
+        while ((before_gap_size() > 0) && ((before_gap[dropped_count] - origin) < count)) {
+            dropped_count += 1;
+        }
+        if ((dropped_count * 2) > static_cast<size_type>(before_gap.size())) {
+            before_gap.erase(before_gap.begin(), before_gap.begin() + dropped_count);
+            dropped_count = 0;
+        }
+        if (before_gap_size() == 0) {
+            while (!after_gap.empty() && (to_offset(after_gap.back()) < count)) {
+                after_gap.pop_back();
+            }
+        }
+        origin += count;
+        content_size -= count;
+    }
+
+    void push_newlines(const Segments<const Element>& content, size_type first, size_type last) {
+        auto position = segmented::find(content, first, last, newline);
+        while (position != last) {
+            before_gap.push_back(position + origin);
+            position = segmented::find(content, position + 1, last, newline);
+        }
+    }
+
+    Element newline;
+    size_type content_size = 0;
+    size_type origin = 0;
+    size_type dropped_count = 0;
+    std::vector<size_type> before_gap;
+    std::vector<size_type> after_gap;
+};
+
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "gap-buffer.hh"
+#include "segmented-algorithm.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace cursor {
+// Which side of an insert at its position a mark stays on. A mark with left
+// gravity stays before the inserted elements, one with right gravity moves
+// after them.
+enum class Gravity {
+    left,
+    right
+};
+
+// Tracks positions in a GapBuffer it observes through edits. Marks keep
+// their place relative to the surrounding content: inserts and removes
+// before a mark shift it, and removing the content around a mark moves it to
+// the start of the removed range.
+//
+// Like LineIndex the set keeps a gap at the position of the most recent
+// edit. Marks before the gap store their offset from the start of the
+// content, marks after the gap their distance from the end, so an edit at
+// the gap leaves the marks around it untouched, and moving the gap only
+// converts the marks it passes over. Both sides are kept ordered by position
+// and gravity as stacks with the marks nearest to the gap last.
+template<typename Element>
+class MarkSet : public GapBufferObserver<Element> {
+public:
+    using size_type = std::ptrdiff_t;
+    using mark_type = std::ptrdiff_t;
+
+    // Marks beyond the end of new content move to the end.
+    void reset(const Segments<const Element>& content) override {
+        move_gap_to_end();
+        content_size = segmented::size(content);
+        for (auto mark : before_gap) {
+            slots[mark].value = std::min(slots[mark].value, content_size);
+        }
+        std::stable_sort(before_gap.begin(), before_gap.end(), [this](mark_type lhs, mark_type rhs) {
+            return is_before(lhs, slots[rhs].value, slots[rhs].gravity);
+        });
+    }
+
+    void inserted(const Segments<const Element>&, size_type position, size_type count) override {
+        move_gap(position, Gravity::right);
+        content_size += count;
+    }
+
+    void removing(const Segments<const Element>&, size_type position, size_type count) override {
+        move_gap(position, Gravity::left);
+        clamped.clear();
+        while (!after_gap.empty() && (to_offset(slots[after_gap.back()].value) <= (position + count))) {
+            clamped.push_back(after_gap.back());
+            after_gap.pop_back();
+        }
+        for (auto gravity : {Gravity::left, Gravity::right}) {
+            for (auto mark : clamped) {
+                if (slots[mark].gravity == gravity) {
+                    set_before_gap(mark, position);
+                }
+            }
+        }
+        content_size -= count;
+    }
+
+    // Adds a mark at position and returns it.
+    mark_type add(size_type position, Gravity gravity = Gravity::left) {
+        validate_position(position);
+        mark_type mark;
+        if (free_marks.empty()) {
+            mark = slots.size();
+            slots.emplace_back();
+        } else {
+            mark = free_marks.back();
+            free_marks.pop_back();
+        }
+        auto& slot = slots[mark];
+        slot.is_live = true;
+        slot.gravity = gravity;
+        slot.value = position;
+        slot.is_after_gap = false;
+        insert_ordered(mark);
+        return mark;
+    }
+
+    void remove(mark_type mark) {
+        validate_mark(mark);
+        auto& stack = slots[mark].is_after_gap ? after_gap : before_gap;
+        stack.erase(std::find(stack.begin(), stack.end(), mark));
+        slots[mark].is_live = false;
+        free_marks.push_back(mark);
+    }
+
+    size_type position(mark_type mark) const {
+        validate_mark(mark);
+        return offset_of(mark);
+    }
+
+    Gravity gravity(mark_type mark) const {
+        validate_mark(mark);
+        return slots[mark].gravity;
+    }
+
+    void set_position(mark_type mark, size_type position) {
+        const auto gravity = this->gravity(mark);
+        remove(mark);
+        add(position, gravity);
+    }
+
+    size_type size() const {
+        return before_gap.size() + after_gap.size();
+    }
+
+private:
+    struct Slot {
+        size_type value = 0;
+        Gravity gravity = Gravity::left;
+        bool is_after_gap = false;
+        bool is_live = false;
+    };
+
+    void validate_position(size_type position) const {
+        if ((position < 0) || (position > content_size)) {
+            throw std::out_of_range("Invalid position");
+        }
+    }
+
+    void validate_mark(mark_type mark) const {
+        if ((mark < 0) || (mark >= static_cast<mark_type>(slots.size())) || !slots[mark].is_live) {
+            throw std::out_of_range("Invalid mark");
+        }
+    }
+
+    size_type offset_of(mark_type mark) const {
+        const auto& slot = slots[mark];
+        return slot.is_after_gap ? to_offset(slot.value) : slot.value;
+    }
+
+    size_type to_offset(size_type distance_from_end) const {
+        return content_size - distance_from_end;
+    }
+
+    size_type to_distance_from_end(size_type offset) const {
+        return content_size - offset;
+    }
+
+    // Marks are ordered by position, and at the same position marks with left
+    // gravity come first.
+    bool is_before(mark_type mark, size_type position, Gravity gravity) const {
+        const auto mark_position = offset_of(mark);
+        return (mark_position < position) || ((mark_position == position) && (slots[mark].gravity < gravity));
+    }
+
+    void set_before_gap(mark_type mark, size_type offset) {
+        slots[mark].value = offset;
+        slots[mark].is_after_gap = false;
+        before_gap.push_back(mark);
+    }
+
+    void set_after_gap(mark_type mark, size_type offset) {
+        slots[mark].value = to_distance_from_end(offset);
+        slots[mark].is_after_gap = true;
+        after_gap.push_back(mark);
+    }
+
+    // Moves the gap so that the marks ordered before position and gravity
+    // are before it and the others after it.
+    void move_gap(size_type position, Gravity gravity) {
+        while (!before_gap.empty() && !is_before(before_gap.back(), position, gravity)) {
+            const auto mark = before_gap.back();
+            before_gap.pop_back();
+            set_after_gap(mark, slots[mark].value);
+        }
+        while (!after_gap.empty() && is_before(after_gap.back(), position, gravity)) {
+            const auto mark = after_gap.back();
+            after_gap.pop_back();
+            set_before_gap(mark, to_offset(slots[mark].value));
+        }
+    }
+
+    void move_gap_to_end() {
+        while (!after_gap.empty()) {
+            const auto mark = after_gap.back();
+            after_gap.pop_back();
+            set_before_gap(mark, to_offset(slots[mark].value));
+        }
+    }
+
+    // Inserts a mark whose slot holds its offset into the side of the gap
+    // and the place that keep both sides ordered.
+    void insert_ordered(mark_type mark) {
+        const auto position = slots[mark].value;
+        const auto gravity = slots[mark].gravity;
+        const auto is_before_mark = [this, position, gravity](mark_type other) {
+            return is_before(other, position, gravity);
+        };
+        if (!after_gap.empty() && is_before_mark(after_gap.back())) {
+            const auto found = std::partition_point(after_gap.rbegin(), after_gap.rend(), is_before_mark);
+            slots[mark].value = to_distance_from_end(position);
+            slots[mark].is_after_gap = true;
+            after_gap.insert(found.base(), mark);
+        } else {
+            const auto found = std::partition_point(before_gap.begin(), before_gap.end(), is_before_mark);
+            slots[mark].is_after_gap = false;
+            before_gap.insert(found, mark);
+        }
+    }
+
+    size_type content_size = 0;
+    std::vector<Slot> slots;
+    std::vector<mark_type> free_marks;
+    std::vector<mark_type> before_gap;
+    std::vector<mark_type> after_gap;
+    std::vector<mark_type> clamped;
+};
+
+}
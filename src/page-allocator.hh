@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace cursor {
+// Allocates whole pages straight from the kernel with anonymous private
+// mappings. Storage allocated this way is page aligned, and parts of it can
+// be replaced by file mappings, which is what lazily mapped files rely on.
+template<typename Element>
+class PageAllocator {
+public:
+    using value_type = Element;
+    using propagate_on_container_move_assignment = std::true_type;
+    using is_always_equal = std::true_type;
+
+    PageAllocator() {}
+
+    template<typename OtherElement>
+    PageAllocator(const PageAllocator<OtherElement>&) {}
+
+    static std::size_t page_size() {
+        static const auto size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static std::size_t round_to_pages(std::size_t size) {
+        return ((size + page_size() - 1) / page_size()) * page_size();
+    }
+
+    Element* allocate(std::size_t count) {
+        const auto mapping = mmap(nullptr, round_to_pages(count * sizeof(Element)), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        return static_cast<Element*>(mapping);
+    }
+
+    void deallocate(Element* allocation, std::size_t count) {
+        munmap(allocation, round_to_pages(count * sizeof(Element)));
+    }
+
+    template<typename OtherElement>
+    bool operator==(const PageAllocator<OtherElement>&) const { return true; }
+
+    template<typename OtherElement>
+    bool operator!=(const PageAllocator<OtherElement>&) const { return false; }
+};
+
+}
@@ -0,0 +1,270 @@
+#pragma once
+
+#include "byte-search.hh"
+#include "gap-buffer.hh"
+#include "range.hh"
+#include "segmented-algorithm.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cursor {
+namespace parallel {
+// A fixed set of worker threads that run the tasks of one job at a time. The
+// thread that runs a job works on it too, so a pool of thread_count threads
+// starts thread_count - 1 workers.
+class ThreadPool {
+public:
+    using size_type = std::ptrdiff_t;
+
+    static int default_thread_count() {
+        return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+
+    explicit ThreadPool(int thread_count_ = default_thread_count()) {
+        for (auto worker = 1; worker < thread_count_; ++worker) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            is_stopping = true;
+        }
+        job_started.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    int thread_count() const {
+        return static_cast<int>(workers.size()) + 1;
+    }
+
+    // Calls task with every index in [0, task_count) across the threads and
+    // returns once they have all returned. If tasks throw, the first
+    // exception is rethrown once the others are done. Jobs of several threads
+    // run one after the other.
+    template<typename Task>
+    void run(size_type task_count, Task task) {
+        std::lock_guard<std::mutex> run_lock{run_mutex};
+        const std::function<void(size_type)> task_function{std::move(task)};
+        Job run_job{task_function, task_count};
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            job = &run_job;
+            generation += 1;
+        }
+        job_started.notify_all();
+        run_tasks(run_job);
+
+        std::unique_lock<std::mutex> lock{mutex};
+        job_finished.wait(lock, [this]() { return active_count == 0; });
+        job = nullptr;
+        if (run_job.error) {
+            std::rethrow_exception(run_job.error);
+        }
+    }
+
+private:
+    struct Job {
+        Job(const std::function<void(size_type)>& task_, size_type task_count_)
+            : task{task_}, task_count{task_count_} {}
+
+        const std::function<void(size_type)>& task;
+        size_type task_count;
+        std::atomic<size_type> next_task{0};
+        std::exception_ptr error;
+    };
+
+    void work() {
+        std::unique_lock<std::mutex> lock{mutex};
+        std::size_t seen_generation = 0;
+        while (true) {
+            job_started.wait(lock, [this, seen_generation]() {
+                return is_stopping || ((job != nullptr) && (generation != seen_generation));
+            });
+            if (is_stopping) {
+                return;
+            }
+            seen_generation = generation;
+            auto worker_job = job;
+            active_count += 1;
+            lock.unlock();
+            run_tasks(*worker_job);
+            lock.lock();
+            active_count -= 1;
+            if (active_count == 0) {
+                job_finished.notify_all();
+            }
+        }
+    }
+
+    void run_tasks(Job& run_job) {
+        while (true) {
+            const auto index = run_job.next_task.fetch_add(1);
+            if (index >= run_job.task_count) {
+                return;
+            }
+            try {
+                run_job.task(index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock{mutex};
+                if (!run_job.error) {
+                    run_job.error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex;
+    std::mutex mutex;
+    std::condition_variable job_started;
+    std::condition_variable job_finished;
+    Job* job = nullptr;
+    std::size_t generation = 0;
+    int active_count = 0;
+    bool is_stopping = false;
+};
+
+// The content is split into chunks of about this many bytes, small enough to
+// stay in the cache of the core that works on it and large enough to make
+// the cost of handing out a chunk negligible.
+constexpr std::ptrdiff_t default_chunk_bytes = 256 << 10;
+
+namespace detail {
+template<typename Segmented>
+using element_of = std::remove_const_t<
+    std::remove_pointer_t<decltype(segmented::segments_of(std::declval<const Segmented&>()).before_gap.begin())>>;
+
+template<typename Element>
+std::ptrdiff_t chunk_size_of(std::ptrdiff_t chunk_bytes) {
+    return std::max(chunk_bytes / static_cast<std::ptrdiff_t>(sizeof(Element)), std::ptrdiff_t{1});
+}
+
+// Calls chunk_function with the index, position and size of every chunk of
+// chunk_size elements in the content, across the threads of the pool.
+template<typename ChunkFunction>
+void for_each_chunk(ThreadPool& pool, std::ptrdiff_t content_size, std::ptrdiff_t chunk_size,
+    ChunkFunction chunk_function) {
+    const auto chunk_count = (content_size + chunk_size - 1) / chunk_size;
+    pool.run(chunk_count, [content_size, chunk_size, &chunk_function](std::ptrdiff_t chunk) {
+        const auto position = chunk * chunk_size;
+        chunk_function(chunk, position, std::min(chunk_size, content_size - position));
+    });
+}
+
+inline std::ptrdiff_t count(const char* first, const char* last, char value) {
+    return byte_search::count(first, last, value);
+}
+
+template<typename Element, typename Value>
+std::ptrdiff_t count(const Element* first, const Element* last, const Value& value) {
+    return std::count(first, last, value);
+}
+}
+
+// Counts the elements equal to value, like segmented::count.
+template<typename Segmented, typename Value>
+std::ptrdiff_t count(ThreadPool& pool, const Segmented& segmented, const Value& value,
+    std::ptrdiff_t chunk_bytes = default_chunk_bytes) {
+    using Element = detail::element_of<Segmented>;
+    const auto content_size = segmented::size(segmented);
+    const auto chunk_size = detail::chunk_size_of<Element>(chunk_bytes);
+    std::atomic<std::ptrdiff_t> value_count{0};
+    detail::for_each_chunk(pool, content_size, chunk_size,
+        [&segmented, &value, &value_count](std::ptrdiff_t, std::ptrdiff_t position, std::ptrdiff_t count) {
+            std::ptrdiff_t chunk_count = 0;
+            segmented::for_each_segment(segmented, position, count, [&value, &chunk_count](auto first, auto last) {
+                chunk_count += detail::count(first, last, value);
+            });
+            value_count += chunk_count;
+        });
+    return value_count;
+}
+
+// Applies transform to every element and folds the results into init with
+// reduce, like std::transform_reduce. The chunks are reduced separately and
+// their results combined in order, so reduce must be associative, and init
+// is folded in once.
+template<typename Segmented, typename Value, typename Reduce, typename Transform>
+Value transform_reduce(ThreadPool& pool, const Segmented& segmented, Value init, Reduce reduce, Transform transform,
+    std::ptrdiff_t chunk_bytes = default_chunk_bytes) {
+    using Element = detail::element_of<Segmented>;
+    const auto content_size = segmented::size(segmented);
+    const auto chunk_size = detail::chunk_size_of<Element>(chunk_bytes);
+    const auto chunk_count = (content_size + chunk_size - 1) / chunk_size;
+    std::vector<Value> chunk_values(chunk_count, init);
+    std::vector<char> is_chunk_empty(chunk_count, 1);
+    detail::for_each_chunk(pool, content_size, chunk_size,
+        [&](std::ptrdiff_t chunk, std::ptrdiff_t position, std::ptrdiff_t count) {
+            auto is_empty = true;
+            segmented::for_each_segment(segmented, position, count, [&](auto first, auto last) {
+                for (auto element = first; element != last; ++element) {
+                    chunk_values[chunk] = is_empty ? Value(transform(*element))
+                                                   : reduce(std::move(chunk_values[chunk]), transform(*element));
+                    is_empty = false;
+                }
+            });
+            is_chunk_empty[chunk] = is_empty;
+        });
+    auto value = std::move(init);
+    for (std::ptrdiff_t chunk = 0; chunk < chunk_count; ++chunk) {
+        if (!is_chunk_empty[chunk]) {
+            value = reduce(std::move(value), std::move(chunk_values[chunk]));
+        }
+    }
+    return value;
+}
+
+// Returns the positions of every occurrence of the needle in order,
+// including occurrences that overlap. Each chunk is searched together with
+// the first needle size - 1 bytes of the next one, so that the occurrences
+// that start in a chunk are found by its own search wherever they end, and
+// byte_search::search finds those that span the gap.
+template<typename Segmented>
+std::vector<std::ptrdiff_t> find_all(ThreadPool& pool, const Segmented& segmented, const char* needle_first,
+    const char* needle_last, std::ptrdiff_t chunk_bytes = default_chunk_bytes) {
+    const auto needle_size = needle_last - needle_first;
+    if (needle_size == 0) {
+        return {};
+    }
+    const auto content_size = segmented::size(segmented);
+    const auto chunk_size = detail::chunk_size_of<char>(chunk_bytes);
+    const auto chunk_count = (content_size + chunk_size - 1) / chunk_size;
+    std::vector<std::vector<std::ptrdiff_t>> chunk_positions(chunk_count);
+    detail::for_each_chunk(pool, content_size, chunk_size,
+        [&](std::ptrdiff_t chunk, std::ptrdiff_t position, std::ptrdiff_t count) {
+            const auto searched_count = std::min(count + needle_size - 1, content_size - position);
+            const auto searched = segmented::subsegments(segmented, position, searched_count);
+            auto& positions = chunk_positions[chunk];
+            auto found = byte_search::search(searched, 0, needle_first, needle_last);
+            while (found < count) {
+                positions.push_back(position + found);
+                found = byte_search::search(searched, found + 1, needle_first, needle_last);
+            }
+        });
+
+    std::vector<std::ptrdiff_t> positions;
+    for (const auto& chunk_position : chunk_positions) {
+        positions.insert(positions.end(), chunk_position.begin(), chunk_position.end());
+    }
+    return positions;
+}
+
+}
+}
@@ -0,0 +1,388 @@
+#pragma once
+
+#include "range.hh"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+
+namespace cursor {
+// A sequence of elements described as pieces of two buffers: the original
+// content, which is never modified, and an add buffer that inserted elements
+// are appended to. An edit splits or trims the pieces around it and never
+// moves the content, so its cost depends on the number of pieces rather than
+// on the size of the content. That suits large files that are mostly read
+// and see a handful of edits, where a GapBuffer would copy everything between
+// two distant edits.
+//
+// The original content is held by a shared pointer, so copies of the table,
+// and tables assigned the same original, share it. The original can be a
+// read only mapping of a file, as made by io::map. The elements can only be
+// read through the iterators.
+template<typename Element, typename Allocator = std::allocator<Element>>
+class PieceTable {
+    struct Piece;
+
+public:
+    class Iterator : public boost::iterator_facade<Iterator, const Element, boost::random_access_traversal_tag> {
+    public:
+        using Facade = boost::iterator_facade<Iterator, const Element, boost::random_access_traversal_tag>;
+        using difference_type = typename Facade::difference_type;
+        using value_type = typename Facade::value_type;
+        using pointer = typename Facade::pointer;
+        using reference = typename Facade::reference;
+        using iterator_category = typename Facade::iterator_category;
+
+        Iterator() {}
+
+    private:
+        friend class boost::iterator_core_access;
+        friend class PieceTable;
+
+        Iterator(const PieceTable* owner_, std::size_t piece_, difference_type offset_)
+            : owner{owner_}, piece{piece_}, offset{offset_} {
+            load_piece();
+        }
+
+        bool equal(const Iterator& other) const {
+            return (piece == other.piece) && (offset == other.offset);
+        }
+
+        reference dereference() const {
+            return elements[offset];
+        }
+
+        void increment() {
+            offset += 1;
+            if (offset == piece_size) {
+                piece += 1;
+                offset = 0;
+                load_piece();
+            }
+        }
+
+        void decrement() {
+            if (offset == 0) {
+                piece -= 1;
+                load_piece();
+                offset = piece_size;
+            }
+            offset -= 1;
+        }
+
+        void advance(difference_type count) {
+            const auto new_offset = offset + count;
+            if ((new_offset >= 0) && (new_offset < piece_size)) {
+                offset = new_offset;
+                return;
+            }
+            std::tie(piece, offset) = owner->locate(position() + count);
+            load_piece();
+        }
+
+        difference_type distance_to(const Iterator& other) const {
+            return other.position() - position();
+        }
+
+        difference_type position() const {
+            return owner->piece_position(piece) + offset;
+        }
+
+        void load_piece() {
+            if (piece < owner->pieces.size()) {
+                elements = owner->piece_elements(owner->pieces[piece]);
+                piece_size = owner->pieces[piece].size;
+            } else {
+                elements = nullptr;
+                piece_size = 0;
+            }
+        }
+
+        const PieceTable* owner = nullptr;
+        std::size_t piece = 0;
+        difference_type offset = 0;
+        const Element* elements = nullptr;
+        difference_type piece_size = 0;
+    };
+
+    using allocator_type = Allocator;
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+    using size_type = std::ptrdiff_t;
+    using range = Range<iterator>;
+    using const_range = Range<const_iterator>;
+
+    PieceTable() {}
+
+    explicit PieceTable(const allocator_type& allocator) : added{allocator} {}
+
+    PieceTable(std::shared_ptr<const Element> original_, size_type original_size_,
+        const allocator_type& allocator = allocator_type{})
+        : added{allocator} {
+        assign(std::move(original_), original_size_);
+    }
+
+    allocator_type get_allocator() const { return added.get_allocator(); }
+
+    // Replaces the content with the original_size elements at original.
+    void assign(std::shared_ptr<const Element> original_, size_type original_size_) {
+        original = std::move(original_);
+        original_size = original_size_;
+        added.clear();
+        pieces.clear();
+        if (original_size > 0) {
+            pieces.push_back({Source::original, 0, original_size, original_size});
+        }
+    }
+
+    // Replaces the content with a copy of the elements of original_range,
+    // which becomes the new original. The copy is made with the allocator of
+    // the table.
+    template<typename ElementRange>
+    void assign(ElementRange original_range) {
+        const auto size = static_cast<size_type>(original_range.size());
+        auto allocator = get_allocator();
+        const auto copy = AllocatorTraits::allocate(allocator, size);
+        auto element = copy;
+        try {
+            for (auto source = original_range.begin(); source != original_range.end(); ++source, ++element) {
+                AllocatorTraits::construct(allocator, element, *source);
+            }
+        } catch (...) {
+            CopyDeleter{allocator, element - copy, size}(copy);
+            throw;
+        }
+        assign(std::shared_ptr<const Element>{copy, CopyDeleter{allocator, size, size}, allocator}, size);
+    }
+
+    const std::shared_ptr<const Element>& get_original() const { return original; }
+    size_type get_original_size() const { return original_size; }
+
+    template<typename ElementRange>
+    void insert(ElementRange insert_range, size_type position) {
+        validate_position(position);
+        const auto start = static_cast<size_type>(added.size());
+        added.insert(added.end(), insert_range.begin(), insert_range.end());
+        const auto count = static_cast<size_type>(added.size()) - start;
+        if (count == 0) {
+            return;
+        }
+
+        auto located = locate(position);
+        auto index = located.first;
+        const auto offset = located.second;
+        if (offset == 0) {
+            // Typing extends the piece that the previous insert added.
+            if ((index > 0) && is_added_last(pieces[index - 1], start)) {
+                pieces[index - 1].size += count;
+                update_ends(index - 1);
+                return;
+            }
+        } else {
+            auto& piece = pieces[index];
+            Piece tail{piece.source, piece.start + offset, piece.size - offset, 0};
+            piece.size = offset;
+            index += 1;
+            pieces.insert(pieces.begin() + index, tail);
+        }
+        pieces.insert(pieces.begin() + index, Piece{Source::added, start, count, 0});
+        update_ends((offset == 0) ? index : (index - 1));
+    }
+
+    template<typename ElementRange>
+    void insert(ElementRange insert_range, const_iterator element) {
+        insert(insert_range, element.position());
+    }
+
+    template<typename ElementRange>
+    void append(ElementRange append_range) {
+        insert(append_range, size());
+    }
+
+    void remove(size_type position, size_type count) {
+        validate_position(position);
+        if ((count < 0) || ((position + count) > size())) {
+            throw std::out_of_range("Invalid position");
+        }
+        if (count == 0) {
+            return;
+        }
+
+        const auto first = locate(position);
+        const auto last = locate(position + count);
+        auto first_index = first.first;
+        auto last_index = last.first;
+
+        // Elements removed from the end of the add buffer are reclaimed, which
+        // keeps the add buffer from growing when inserts are undone.
+        for (auto index = first_index; (index <= last_index) && (index < pieces.size()); ++index) {
+            const auto& piece = pieces[index];
+            const auto removed_start = piece.start + ((index == first_index) ? first.second : 0);
+            const auto removed_end = piece.start + ((index == last_index) ? last.second : piece.size);
+            if ((piece.source == Source::added) && (removed_start < removed_end)
+                && (removed_end == static_cast<size_type>(added.size()))) {
+                added.erase(added.begin() + removed_start, added.end());
+            }
+        }
+
+        if (first_index == last_index) {
+            auto& piece = pieces[first_index];
+            Piece tail{piece.source, piece.start + last.second, piece.size - last.second, 0};
+            piece.size = first.second;
+            pieces.insert(pieces.begin() + first_index + 1, tail);
+            last_index += 1;
+        } else {
+            pieces[first_index].size = first.second;
+            if (last_index < pieces.size()) {
+                auto& piece = pieces[last_index];
+                piece.start += last.second;
+                piece.size -= last.second;
+            }
+        }
+        pieces.erase(pieces.begin() + first_index + 1, pieces.begin() + last_index);
+
+        // Leaves the piece before the removed elements at first_index and the
+        // one after them at first_index + 1, dropping whichever is empty and
+        // joining them if they are adjacent in the same buffer.
+        auto seam = first_index + 1;
+        if ((seam < pieces.size()) && (pieces[seam].size == 0)) {
+            pieces.erase(pieces.begin() + seam);
+        }
+        if (pieces[first_index].size == 0) {
+            pieces.erase(pieces.begin() + first_index);
+            seam = first_index;
+        }
+        if ((seam > 0) && (seam < pieces.size()) && are_adjacent(pieces[seam - 1], pieces[seam])) {
+            pieces[seam - 1].size += pieces[seam].size;
+            pieces.erase(pieces.begin() + seam);
+        }
+        update_ends((seam > 0) ? (seam - 1) : 0);
+    }
+
+    void remove(const_range remove_range) {
+        const auto position = remove_range.begin().position();
+        remove(position, remove_range.end().position() - position);
+    }
+
+    template<typename ElementRange>
+    void replace(size_type position, size_type count, ElementRange insert_range) {
+        remove(position, count);
+        insert(insert_range, position);
+    }
+
+    template<typename ElementRange>
+    void replace(const_range remove_range, ElementRange insert_range) {
+        const auto position = remove_range.begin().position();
+        replace(position, remove_range.end().position() - position, insert_range);
+    }
+
+    void clear() {
+        assign(nullptr, 0);
+    }
+
+    size_type size() const { return pieces.empty() ? 0 : pieces.back().end; }
+    size_type piece_count() const { return pieces.size(); }
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, pieces.size(), 0); }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // Calls function with the first and last pointer of every piece in
+    // order, which is the fast way to visit the content.
+    template<typename Function>
+    Function for_each_segment(Function function) const {
+        for (const auto& piece : pieces) {
+            const auto elements = piece_elements(piece);
+            function(elements, elements + piece.size);
+        }
+        return function;
+    }
+
+private:
+    using AllocatorTraits = std::allocator_traits<allocator_type>;
+
+    // Destroys the first constructed_count elements of a copy made by assign
+    // and frees its storage of size elements.
+    struct CopyDeleter {
+        void operator()(Element* elements) {
+            for (auto element = elements; element != (elements + constructed_count); ++element) {
+                AllocatorTraits::destroy(allocator, element);
+            }
+            AllocatorTraits::deallocate(allocator, elements, size);
+        }
+
+        allocator_type allocator;
+        size_type constructed_count;
+        size_type size;
+    };
+
+    enum class Source {
+        original,
+        added
+    };
+
+    struct Piece {
+        Source source;
+        size_type start;
+        size_type size;
+        // The position just after the piece in the content.
+        size_type end;
+    };
+
+    void validate_position(size_type position) const {
+        if ((position < 0) || (position > size())) {
+            throw std::out_of_range("Invalid position");
+        }
+    }
+
+    const Element* piece_elements(const Piece& piece) const {
+        return ((piece.source == Source::original) ? original.get() : added.data()) + piece.start;
+    }
+
+    size_type piece_position(std::size_t index) const {
+        return (index == 0) ? 0 : pieces[index - 1].end;
+    }
+
+    // Returns the index of the piece that holds the element at position and
+    // the offset of the element in the piece, or the number of pieces and 0
+    // for the end of the content.
+    std::pair<std::size_t, size_type> locate(size_type position) const {
+        const auto found = std::upper_bound(pieces.begin(), pieces.end(), position,
+            [](size_type position_, const Piece& piece) { return position_ < piece.end; });
+        const std::size_t index = found - pieces.begin();
+        return {index, position - piece_position(index)};
+    }
+
+    bool is_added_last(const Piece& piece, size_type added_size) const {
+        return (piece.source == Source::added) && ((piece.start + piece.size) == added_size);
+    }
+
+    static bool are_adjacent(const Piece& first, const Piece& second) {
+        return (first.source == second.source) && ((first.start + first.size) == second.start);
+    }
+
+    void update_ends(std::size_t first_index) {
+        auto end = piece_position(first_index);
+        for (auto index = first_index; index < pieces.size(); ++index) {
+            end += pieces[index].size;
+            pieces[index].end = end;
+        }
+    }
+
+    std::shared_ptr<const Element> original;
+    size_type original_size = 0;
+    std::vector<Element, Allocator> added;
+    std::vector<Piece> pieces;
+};
+
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "gap-buffer.hh"
+#include "range.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace cursor {
+namespace segmented {
+template<typename Element>
+auto make_segments(Element* first, Element* last) {
+    return Segments<Element>{make_range(first, last), make_range(last, last)};
+}
+
+template<typename Element>
+Segments<const Element> segments_of(const Segments<Element>& segments) {
+    return Segments<const Element>{
+        make_range<const Element*>(segments.before_gap.begin(), segments.before_gap.end()),
+        make_range<const Element*>(segments.after_gap.begin(), segments.after_gap.end())
+    };
+}
+
+template<typename Container>
+auto segments_of(const Container& container) {
+    return container.segments();
+}
+
+template<typename Segmented>
+std::ptrdiff_t size(const Segmented& segmented) {
+    const auto segments = segments_of(segmented);
+    return segments.before_gap.size() + segments.after_gap.size();
+}
+
+template<typename Segmented, typename Function>
+Function for_each_segment(const Segmented& segmented, Function function) {
+    const auto segments = segments_of(segmented);
+    if (segments.before_gap.size() > 0) {
+        function(segments.before_gap.begin(), segments.before_gap.end());
+    }
+    if (segments.after_gap.size() > 0) {
+        function(segments.after_gap.begin(), segments.after_gap.end());
+    }
+    return function;
+}
+
+template<typename Segmented, typename Function>
+Function for_each_segment(const Segmented& segmented, std::ptrdiff_t position, std::ptrdiff_t count, Function function) {
+    const auto segments = segments_of(segmented);
+    const auto before_gap_size = segments.before_gap.size();
+    const auto first = position;
+    const auto last = position + count;
+    if (first < before_gap_size) {
+        const auto before_gap_last = std::min(last, before_gap_size);
+        function(segments.before_gap.begin() + first, segments.before_gap.begin() + before_gap_last);
+    }
+    if (last > before_gap_size) {
+        const auto after_gap_first = std::max(first, before_gap_size) - before_gap_size;
+        const auto after_gap_last = last - before_gap_size;
+        function(segments.after_gap.begin() + after_gap_first, segments.after_gap.begin() + after_gap_last);
+    }
+    return function;
+}
+
+// Returns the segments of the count elements at position, the part of them
+// before the gap first, so that an algorithm over segments can work on part
+// of the content.
+template<typename Segmented>
+auto subsegments(const Segmented& segmented, std::ptrdiff_t position, std::ptrdiff_t count) {
+    using Element = std::remove_pointer_t<decltype(segments_of(segmented).before_gap.begin())>;
+    Segments<Element> result{make_range<Element*>(nullptr, nullptr), make_range<Element*>(nullptr, nullptr)};
+    auto is_first = true;
+    for_each_segment(segmented, position, count, [&result, &is_first](Element* first, Element* last) {
+        (is_first ? result.before_gap : result.after_gap) = make_range(first, last);
+        is_first = false;
+    });
+    return result;
+}
+
+template<typename Segmented, typename OutputIterator>
+OutputIterator copy(const Segmented& segmented, OutputIterator output) {
+    for_each_segment(segmented, [&output](auto first, auto last) {
+        output = std::copy(first, last, output);
+    });
+    return output;
+}
+
+// Copies the count elements starting at position.
+template<typename Segmented, typename OutputIterator>
+OutputIterator copy(const Segmented& segmented, std::ptrdiff_t position, std::ptrdiff_t count, OutputIterator output) {
+    for_each_segment(segmented, position, count, [&output](auto first, auto last) {
+        output = std::copy(first, last, output);
+    });
+    return output;
+}
+
+template<typename Segmented, typename Function>
+Function for_each(const Segmented& segmented, Function function) {
+    for_each_segment(segmented, [&function](auto first, auto last) {
+        for (auto element = first; element != last; ++element) {
+            function(*element);
+        }
+    });
+    return function;
+}
+
+template<typename Segmented, typename Value>
+std::ptrdiff_t count(const Segmented& segmented, const Value& value) {
+    std::ptrdiff_t value_count = 0;
+    for_each_segment(segmented, [&value_count, &value](auto first, auto last) {
+        value_count += std::count(first, last, value);
+    });
+    return value_count;
+}
+
+namespace detail {
+template<typename Element>
+using is_byte = std::integral_constant<bool, std::is_integral<Element>::value && (sizeof(Element) == 1)>;
+
+template<typename Element, typename Value>
+const Element* find(const Element* first, const Element* last, const Value& value, std::true_type) {
+    const auto byte = static_cast<Element>(value);
+    if ((first == last) || (static_cast<Value>(byte) != value)) {
+        return last;
+    }
+    const auto found = std::memchr(first, static_cast<unsigned char>(byte), last - first);
+    return (found == nullptr) ? last : static_cast<const Element*>(found);
+}
+
+template<typename Element, typename Value>
+const Element* find(const Element* first, const Element* last, const Value& value, std::false_type) {
+    return std::find(first, last, value);
+}
+}
+
+// Returns the position of the first element equal to value in the range
+// [first, last) of positions, or last if there is none.
+template<typename Segmented, typename Value>
+std::ptrdiff_t find(const Segmented& segmented, std::ptrdiff_t first, std::ptrdiff_t last, const Value& value) {
+    const auto segments = segments_of(segmented);
+    using Element = std::remove_const_t<std::remove_pointer_t<decltype(segments.before_gap.begin())>>;
+    using IsByte = detail::is_byte<Element>;
+
+    const auto& before_gap = segments.before_gap;
+    const auto before_gap_size = before_gap.size();
+    if (first < before_gap_size) {
+        const auto before_gap_last = before_gap.begin() + std::min(last, before_gap_size);
+        const auto found = detail::find(before_gap.begin() + first, before_gap_last, value, IsByte{});
+        if (found != before_gap_last) {
+            return found - before_gap.begin();
+        }
+    }
+
+    if (last > before_gap_size) {
+        const auto& after_gap = segments.after_gap;
+        const auto after_gap_first = after_gap.begin() + (std::max(first, before_gap_size) - before_gap_size);
+        const auto after_gap_last = after_gap.begin() + (last - before_gap_size);
+        const auto found = detail::find(after_gap_first, after_gap_last, value, IsByte{});
+        return before_gap_size + (found - after_gap.begin());
+    }
+
+    return last;
+}
+
+// Returns the position of the first element equal to value, or the size of
+// the content if there is none.
+template<typename Segmented, typename Value>
+std::ptrdiff_t find(const Segmented& segmented, const Value& value) {
+    return find(segmented, 0, size(segmented), value);
+}
+
+template<typename LhsSegmented, typename RhsSegmented>
+bool equal(const LhsSegmented& lhs, const RhsSegmented& rhs) {
+    const auto lhs_segments = segments_of(lhs);
+    const auto rhs_segments = segments_of(rhs);
+    if (size(lhs_segments) != size(rhs_segments)) {
+        return false;
+    }
+
+    auto lhs_range = lhs_segments.before_gap;
+    auto rhs_range = rhs_segments.before_gap;
+    auto is_lhs_after_gap = false;
+    auto is_rhs_after_gap = false;
+    while (true) {
+        if ((lhs_range.size() == 0) && !is_lhs_after_gap) {
+            lhs_range = lhs_segments.after_gap;
+            is_lhs_after_gap = true;
+            continue;
+        }
+        if ((rhs_range.size() == 0) && !is_rhs_after_gap) {
+            rhs_range = rhs_segments.after_gap;
+            is_rhs_after_gap = true;
+            continue;
+        }
+        const auto count = std::min(lhs_range.size(), rhs_range.size());
+        if (count == 0) {
+            return true;
+        }
+        if (!std::equal(lhs_range.begin(), lhs_range.begin() + count, rhs_range.begin())) {
+            return false;
+        }
+        lhs_range = make_range(lhs_range.begin() + count, lhs_range.end());
+        rhs_range = make_range(rhs_range.begin() + count, rhs_range.end());
+    }
+}
+
+}
+}
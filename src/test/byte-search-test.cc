@@ -0,0 +1,114 @@
+#include "byte-search.hh"
+#include "gap-buffer.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace byte_search {
+namespace {
+
+using cursor::byte_search::Isa;
+
+auto supported_isas()
+{
+    std::vector<Isa> isas;
+    for (auto isa : { Isa::scalar, Isa::sse2, Isa::avx2 }) {
+        if (cursor::byte_search::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+template <typename RandomEngine> auto make_random_text(RandomEngine& random_engine, int size)
+{
+    const std::string alphabet = "ab\n";
+    std::uniform_int_distribution<> letter_distribution{ 0, static_cast<int>(alphabet.size()) - 1 };
+    std::string text(size, ' ');
+    for (auto& letter : text) {
+        letter = alphabet[letter_distribution(random_engine)];
+    }
+    return text;
+}
+
+auto make_gap_buffer(const std::string& content, int gap_position)
+{
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(gap_position, 0);
+    return gap_buffer;
+}
+
+void count_and_find()
+{
+    std::mt19937 random_engine;
+    for (auto isa : supported_isas()) {
+        for (auto size = 0; size < 200; ++size) {
+            const auto text = make_random_text(random_engine, size);
+            const auto first = text.data();
+            const auto last = text.data() + text.size();
+            ASSERT_EQ(std::count(text.begin(), text.end(), '\n'), cursor::byte_search::count(first, last, '\n', isa));
+            ASSERT_EQ(std::find(first, last, '\n'), cursor::byte_search::find(first, last, '\n', isa));
+            ASSERT_EQ(last, cursor::byte_search::find(first, last, 'x', isa));
+        }
+    }
+}
+
+void search()
+{
+    std::mt19937 random_engine;
+    for (auto isa : supported_isas()) {
+        for (auto size = 0; size < 200; ++size) {
+            const auto text = make_random_text(random_engine, size);
+            for (auto needle_size = 0; needle_size < 6; ++needle_size) {
+                const auto needle = make_random_text(random_engine, needle_size);
+                const auto first = text.data();
+                const auto last = text.data() + text.size();
+                const auto expected = std::search(first, last, needle.data(), needle.data() + needle.size());
+                const auto found
+                    = cursor::byte_search::search(first, last, needle.data(), needle.data() + needle.size(), isa);
+                ASSERT_EQ(expected, found);
+            }
+        }
+    }
+}
+
+void segmented_search()
+{
+    std::mt19937 random_engine;
+    for (auto isa : supported_isas()) {
+        const auto text = make_random_text(random_engine, 100);
+        for (auto gap_position = 0; gap_position <= static_cast<int>(text.size()); ++gap_position) {
+            const auto gap_buffer = make_gap_buffer(text, gap_position);
+            ASSERT_EQ(std::count(text.begin(), text.end(), 'a'), cursor::byte_search::count(gap_buffer, 'a', isa));
+            for (auto position = 0; position <= static_cast<int>(text.size()); position += 7) {
+                const auto expected_byte = std::min(text.find('\n', position), text.size());
+                ASSERT_EQ(expected_byte, cursor::byte_search::find(gap_buffer, position, '\n', isa));
+                for (auto needle_size = 1; needle_size < 5; ++needle_size) {
+                    const auto needle = text.substr(gap_position - std::min(gap_position, needle_size / 2), needle_size);
+                    const auto expected = std::min(text.find(needle, position), text.size());
+                    const auto found = cursor::byte_search::search(
+                        gap_buffer, position, needle.data(), needle.data() + needle.size(), isa);
+                    ASSERT_EQ(expected, found);
+                }
+            }
+        }
+    }
+}
+}
+}
+}
+}
+
+TEST(byte_search, count_and_find) { cursor::test::byte_search::count_and_find(); }
+
+TEST(byte_search, search) { cursor::test::byte_search::search(); }
+
+TEST(byte_search, segmented_search) { cursor::test::byte_search::segmented_search(); }
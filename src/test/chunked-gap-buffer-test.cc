@@ -0,0 +1,122 @@
+#include "chunked-gap-buffer.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace cursor {
+namespace test {
+namespace chunked_gap_buffer {
+namespace {
+
+using SmallChunkedGapBuffer = ChunkedGapBuffer<char, std::allocator<char>, 16>;
+
+std::string to_string(const SmallChunkedGapBuffer& chunked_gap_buffer)
+{
+    return std::string(chunked_gap_buffer.cbegin(), chunked_gap_buffer.cend());
+}
+
+void insert_and_remove()
+{
+    SmallChunkedGapBuffer chunked_gap_buffer;
+    const std::string content = "The quick brown fox jumps over the lazy dog";
+    chunked_gap_buffer.append(make_crange(content));
+    ASSERT_EQ(content, to_string(chunked_gap_buffer));
+    ASSERT_LT(1, chunked_gap_buffer.chunk_count());
+    const std::string word = "very ";
+    chunked_gap_buffer.insert(make_crange(word), 4);
+    ASSERT_EQ("The very quick brown fox jumps over the lazy dog", to_string(chunked_gap_buffer));
+    chunked_gap_buffer.remove(4, 11);
+    ASSERT_EQ("The brown fox jumps over the lazy dog", to_string(chunked_gap_buffer));
+    chunked_gap_buffer.replace(4, 5, make_crange(std::string("red")));
+    ASSERT_EQ("The red fox jumps over the lazy dog", to_string(chunked_gap_buffer));
+    ASSERT_THROW(chunked_gap_buffer.insert(make_crange(word), 36), std::out_of_range);
+    ASSERT_THROW(chunked_gap_buffer.remove(30, 6), std::out_of_range);
+    chunked_gap_buffer.remove(0, chunked_gap_buffer.size());
+    ASSERT_EQ(0, chunked_gap_buffer.size());
+    ASSERT_EQ(0, chunked_gap_buffer.chunk_count());
+}
+
+void iterators()
+{
+    SmallChunkedGapBuffer chunked_gap_buffer;
+    std::string content;
+    for (auto count = 0; count < 100; ++count) {
+        content.push_back('a' + (count % 26));
+    }
+    chunked_gap_buffer.append(make_crange(content));
+    const auto begin = chunked_gap_buffer.begin();
+    const auto end = chunked_gap_buffer.end();
+    ASSERT_EQ(100, end - begin);
+    ASSERT_EQ(content[57], begin[57]);
+    ASSERT_EQ(content[99], *(end - 1));
+    ASSERT_EQ(begin + 10, (end - 90));
+    auto element = begin + 95;
+    element -= 80;
+    ASSERT_EQ(content[15], *element);
+    ASSERT_EQ(15, element - begin);
+    SmallChunkedGapBuffer::const_iterator const_element = element;
+    ASSERT_EQ(content[15], *const_element);
+    using ReverseIterator = std::reverse_iterator<SmallChunkedGapBuffer::iterator>;
+    const std::string reversed{ ReverseIterator{ end }, ReverseIterator{ begin } };
+    ASSERT_TRUE(std::equal(reversed.rbegin(), reversed.rend(), content.begin()));
+    *element = '-';
+    content[15] = '-';
+    ASSERT_EQ(content, to_string(chunked_gap_buffer));
+    std::string segments;
+    chunked_gap_buffer.for_each_segment([&segments](const char* first, const char* last) {
+        segments.append(first, last);
+    });
+    ASSERT_EQ(content, segments);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> word_size_distribution{ 0, 40 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    SmallChunkedGapBuffer chunked_gap_buffer;
+    std::string expected;
+    for (auto count = 0; count < 5000; ++count) {
+        const auto content_size = static_cast<int>(expected.size());
+        const std::string word(word_size_distribution(random_engine), 'a' + (count % 26));
+        std::uniform_int_distribution<> position_distribution{ 0, content_size };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(48, content_size - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0:
+            chunked_gap_buffer.insert(make_crange(word), position);
+            expected.insert(position, word);
+            break;
+        case 1:
+            chunked_gap_buffer.remove(position, remove_count);
+            expected.erase(position, remove_count);
+            break;
+        default:
+            chunked_gap_buffer.replace(position, remove_count, make_crange(word));
+            expected.replace(position, remove_count, word);
+            break;
+        }
+        ASSERT_EQ(static_cast<std::ptrdiff_t>(expected.size()), chunked_gap_buffer.size());
+        if ((count % 10) == 0) {
+            ASSERT_EQ(expected, to_string(chunked_gap_buffer));
+            ASSERT_LE(chunked_gap_buffer.chunk_count() * 4, chunked_gap_buffer.size() + 16 * 4);
+        }
+    }
+}
+}
+}
+}
+}
+
+TEST(chunked_gap_buffer, insert_and_remove) { cursor::test::chunked_gap_buffer::insert_and_remove(); }
+
+TEST(chunked_gap_buffer, iterators) { cursor::test::chunked_gap_buffer::iterators(); }
+
+TEST(chunked_gap_buffer, random_edits) { cursor::test::chunked_gap_buffer::random_edits(); }
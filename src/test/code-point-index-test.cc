@@ -0,0 +1,119 @@
+#include "code-point-index.hh"
+#include "gap-buffer.hh"
+#include "line-index.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace code_point_index {
+namespace {
+
+auto code_point_offsets(const std::string& content)
+{
+    std::vector<std::ptrdiff_t> offsets;
+    for (auto offset = 0; offset < static_cast<int>(content.size()); ++offset) {
+        if ((static_cast<unsigned char>(content[offset]) & 0xc0) != 0x80) {
+            offsets.push_back(offset);
+        }
+    }
+    offsets.push_back(content.size());
+    return offsets;
+}
+
+void offsets_and_columns()
+{
+    GapBuffer<char> gap_buffer;
+    CodePointIndex code_point_index;
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&code_point_index);
+    gap_buffer.add_observer(&line_index);
+    const std::string content = "caf\xc3\xa9\n\xe4\xb8\xad\xe6\x96\x87 \xf0\x9f\x98\x80!";
+    gap_buffer.append(make_crange(content));
+    ASSERT_EQ(10, code_point_index.code_point_count());
+    ASSERT_EQ(3, code_point_index.offset_to_code_point(gap_buffer, 3));
+    ASSERT_EQ(4, code_point_index.offset_to_code_point(gap_buffer, 5));
+    ASSERT_EQ(12, code_point_index.code_point_to_offset(gap_buffer, 7));
+    ASSERT_EQ(static_cast<std::ptrdiff_t>(content.size()), code_point_index.code_point_to_offset(gap_buffer, 10));
+    ASSERT_THROW(code_point_index.code_point_to_offset(gap_buffer, 11), std::out_of_range);
+    ASSERT_THROW(code_point_index.offset_to_code_point(gap_buffer, content.size() + 1), std::out_of_range);
+
+    const auto offset = 13;
+    const auto line_start = line_index.line_to_offset(line_index.offset_to_line(offset));
+    const auto column = code_point_index.offset_to_code_point(gap_buffer, offset)
+        - code_point_index.offset_to_code_point(gap_buffer, line_start);
+    ASSERT_EQ(3, column);
+
+    gap_buffer.remove(6, 6);
+    ASSERT_EQ(8, code_point_index.code_point_count());
+    ASSERT_EQ(7, code_point_index.code_point_to_offset(gap_buffer, 6));
+    gap_buffer.remove_observer(&line_index);
+    gap_buffer.remove_observer(&code_point_index);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    const std::vector<std::string> characters = { "a", "\n", "\xc3\xa9", "\xe4\xb8\xad", "\xf0\x9f\x98\x80" };
+    std::uniform_int_distribution<> character_distribution{ 0, static_cast<int>(characters.size()) - 1 };
+    std::uniform_int_distribution<> word_size_distribution{ 0, 800 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    GapBuffer<char> gap_buffer;
+    CodePointIndex code_point_index;
+    gap_buffer.add_observer(&code_point_index);
+    std::string expected;
+    for (auto count = 0; count < 1000; ++count) {
+        std::string word;
+        for (auto size = word_size_distribution(random_engine); size > 0; --size) {
+            word += characters[character_distribution(random_engine)];
+        }
+        // Edits fall on any byte, so that code points are also split and
+        // joined by the edits.
+        const auto content_size = static_cast<int>(expected.size());
+        std::uniform_int_distribution<> position_distribution{ 0, content_size };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(3000, content_size - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0:
+            gap_buffer.insert(make_crange(word), position);
+            expected.insert(position, word);
+            break;
+        case 1:
+            gap_buffer.remove(position, remove_count);
+            expected.erase(position, remove_count);
+            break;
+        default:
+            gap_buffer.replace(position, remove_count, make_crange(word));
+            expected.replace(position, remove_count, word);
+            break;
+        }
+        if ((count % 10) == 0) {
+            const auto offsets = code_point_offsets(expected);
+            const auto code_point_count = static_cast<std::ptrdiff_t>(offsets.size()) - 1;
+            ASSERT_EQ(code_point_count, code_point_index.code_point_count());
+            for (auto code_point = 0; code_point <= code_point_count; code_point += 1 + (code_point_count / 50)) {
+                ASSERT_EQ(offsets[code_point], code_point_index.code_point_to_offset(gap_buffer, code_point));
+                ASSERT_EQ(code_point, code_point_index.offset_to_code_point(gap_buffer, offsets[code_point]));
+            }
+            const auto block_size = CodePointIndex::max_block_size / 4;
+            ASSERT_LE(code_point_index.block_count(), 2 + (2 * static_cast<int>(expected.size())) / block_size);
+        }
+    }
+    gap_buffer.remove_observer(&code_point_index);
+}
+}
+}
+}
+}
+
+TEST(code_point_index, offsets_and_columns) { cursor::test::code_point_index::offsets_and_columns(); }
+
+TEST(code_point_index, random_edits) { cursor::test::code_point_index::random_edits(); }
@@ -0,0 +1,91 @@
+#include "content-hash.hh"
+#include "gap-buffer.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace cursor {
+namespace test {
+namespace content_hash {
+namespace {
+
+void digest()
+{
+    GapBuffer<char> gap_buffer;
+    ContentHash<char> content_hash;
+    gap_buffer.add_observer(&content_hash);
+    ASSERT_EQ(ContentHash<char>::digest_of(std::string()), content_hash.digest());
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    const auto saved_digest = content_hash.digest();
+    ASSERT_EQ(ContentHash<char>::digest_of(content), saved_digest);
+    ASSERT_NE(ContentHash<char>::digest_of(std::string("Hello world")), saved_digest);
+    ASSERT_NE(ContentHash<char>::digest_of(std::string(1, '\0') + content), saved_digest);
+
+    gap_buffer.insert(make_crange(std::string(",")), 5);
+    ASSERT_NE(saved_digest, content_hash.digest());
+    gap_buffer.remove(5, 1);
+    ASSERT_EQ(saved_digest, content_hash.digest());
+    ASSERT_EQ(ContentHash<char>::digest_of(std::string("World")), content_hash.hash(gap_buffer, 6, 5));
+    ASSERT_THROW(content_hash.hash(gap_buffer, 6, 6), std::out_of_range);
+    gap_buffer.remove_observer(&content_hash);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> letter_distribution{ 'a', 'z' };
+    std::uniform_int_distribution<> word_size_distribution{ 0, 3000 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    GapBuffer<char> gap_buffer;
+    ContentHash<char> content_hash;
+    gap_buffer.add_observer(&content_hash);
+    std::string expected(20000, 'a');
+    std::generate(expected.begin(), expected.end(), [&]() { return static_cast<char>(letter_distribution(random_engine)); });
+    gap_buffer.append(make_crange(expected));
+    for (auto count = 0; count < 1000; ++count) {
+        const auto content_size = static_cast<int>(expected.size());
+        std::string word(word_size_distribution(random_engine), 'a');
+        std::generate(word.begin(), word.end(), [&]() { return static_cast<char>(letter_distribution(random_engine)); });
+        std::uniform_int_distribution<> position_distribution{ 0, content_size };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(6000, content_size - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0:
+            gap_buffer.insert(make_crange(word), position);
+            expected.insert(position, word);
+            break;
+        case 1:
+            gap_buffer.remove(position, remove_count);
+            expected.erase(position, remove_count);
+            break;
+        default:
+            gap_buffer.replace(position, remove_count, make_crange(word));
+            expected.replace(position, remove_count, word);
+            break;
+        }
+        if ((count % 10) == 0) {
+            ASSERT_EQ(ContentHash<char>::digest_of(expected), content_hash.digest());
+            const auto hash_position = position_distribution(random_engine) % (expected.size() + 1);
+            const auto hash_count = count_distribution(random_engine) % (expected.size() - hash_position + 1);
+            ASSERT_EQ(ContentHash<char>::digest_of(expected.substr(hash_position, hash_count)),
+                content_hash.hash(gap_buffer, hash_position, hash_count));
+            ASSERT_LE(content_hash.block_count(), 2 + (2 * static_cast<int>(expected.size())) / (ContentHash<char>::max_block_size / 2));
+        }
+    }
+    gap_buffer.remove_observer(&content_hash);
+}
+}
+}
+}
+}
+
+TEST(content_hash, digest) { cursor::test::content_hash::digest(); }
+
+TEST(content_hash, random_edits) { cursor::test::content_hash::random_edits(); }
@@ -0,0 +1,242 @@
+#include "edit-journal.hh"
+#include "gap-buffer.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace edit_journal {
+namespace {
+
+auto to_string(const GapBuffer<char>& gap_buffer)
+{
+    return std::string(gap_buffer.cbegin(), gap_buffer.cend());
+}
+
+void type(GapBuffer<char>& gap_buffer, const std::string& text, GapBuffer<char>::size_type position)
+{
+    for (auto letter : text) {
+        gap_buffer.insert(make_crange(std::string(1, letter)), position);
+        position += 1;
+    }
+}
+
+void coalesce_typing()
+{
+    GapBuffer<char> gap_buffer;
+    EditJournal<char> journal;
+    gap_buffer.add_observer(&journal);
+    type(gap_buffer, "Hello\nWorld", 0);
+    ASSERT_EQ(2, journal.record_count());
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("Hello\n", to_string(gap_buffer));
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("", to_string(gap_buffer));
+    ASSERT_FALSE(journal.undo(gap_buffer));
+    ASSERT_TRUE(journal.redo(gap_buffer));
+    ASSERT_TRUE(journal.redo(gap_buffer));
+    ASSERT_EQ("Hello\nWorld", to_string(gap_buffer));
+    ASSERT_FALSE(journal.redo(gap_buffer));
+
+    journal.seal();
+    type(gap_buffer, "!", 11);
+    ASSERT_EQ(3, journal.record_count());
+    gap_buffer.remove_observer(&journal);
+}
+
+void new_edit_discards_redo()
+{
+    GapBuffer<char> gap_buffer;
+    EditJournal<char> journal;
+    gap_buffer.add_observer(&journal);
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(5, 6);
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_TRUE(journal.can_redo());
+    type(gap_buffer, "!", 11);
+    ASSERT_FALSE(journal.can_redo());
+    ASSERT_EQ(2, journal.record_count());
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("Hello World", to_string(gap_buffer));
+    gap_buffer.remove_observer(&journal);
+}
+
+void groups()
+{
+    GapBuffer<char> gap_buffer;
+    EditJournal<char> journal;
+    gap_buffer.add_observer(&journal);
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    const std::string word = "Goodbye";
+    journal.begin_group();
+    gap_buffer.replace(0, 5, make_crange(word));
+    journal.begin_group();
+    gap_buffer.remove(7, 6);
+    journal.end_group();
+    journal.end_group();
+    ASSERT_EQ("Goodbye", to_string(gap_buffer));
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("Hello World", to_string(gap_buffer));
+    ASSERT_TRUE(journal.redo(gap_buffer));
+    ASSERT_EQ("Goodbye", to_string(gap_buffer));
+    ASSERT_FALSE(journal.can_redo());
+    gap_buffer.remove_observer(&journal);
+}
+
+void splice_whole_buffer()
+{
+    GapBuffer<char> destination;
+    GapBuffer<char> source;
+    EditJournal<char> destination_journal;
+    EditJournal<char> source_journal;
+    destination.add_observer(&destination_journal);
+    source.add_observer(&source_journal);
+    destination.append(make_crange(std::string{ "Hello" }));
+    destination.remove(0, 5);
+    source.append(make_crange(std::string{ "World" }));
+    // Taking over the storage of the whole source is journaled like any
+    // other splice.
+    destination.splice(0, source);
+    ASSERT_EQ(3, destination_journal.record_count());
+    ASSERT_EQ(2, source_journal.record_count());
+    ASSERT_TRUE(destination_journal.undo(destination));
+    ASSERT_EQ("", to_string(destination));
+    ASSERT_TRUE(destination_journal.undo(destination));
+    ASSERT_EQ("Hello", to_string(destination));
+    ASSERT_TRUE(source_journal.undo(source));
+    ASSERT_EQ("World", to_string(source));
+    ASSERT_TRUE(source_journal.undo(source));
+    ASSERT_EQ("", to_string(source));
+    destination.remove_observer(&destination_journal);
+    source.remove_observer(&source_journal);
+}
+
+void splice_strings()
+{
+    GapBuffer<std::string> destination;
+    GapBuffer<std::string> source;
+    EditJournal<std::string> source_journal{ std::string{ "\n" } };
+    const std::vector<std::string> words = { "alpha", "beta", "gamma" };
+    destination.append(make_crange(words));
+    source.append(make_crange(words));
+    source.add_observer(&source_journal);
+    // The journal copies the removed elements before they are moved out.
+    destination.splice(1, source, 1, 1);
+    const std::vector<std::string> spliced = { "alpha", "beta", "beta", "gamma" };
+    ASSERT_TRUE(std::equal(spliced.begin(), spliced.end(), destination.cbegin(), destination.cend()));
+    ASSERT_EQ(2, source.size());
+    ASSERT_TRUE(source_journal.undo(source));
+    ASSERT_TRUE(std::equal(words.begin(), words.end(), source.cbegin(), source.cend()));
+    source.remove_observer(&source_journal);
+}
+
+void size_limit()
+{
+    GapBuffer<char> gap_buffer;
+    gap_buffer.set_size_limit(5);
+    EditJournal<char> journal;
+    gap_buffer.add_observer(&journal);
+    // The insert reaches into the dropped front, so it cannot be undone.
+    gap_buffer.append(make_crange(std::string{ "abcdefgh" }));
+    ASSERT_EQ("defgh", to_string(gap_buffer));
+    ASSERT_FALSE(journal.undo(gap_buffer));
+
+    gap_buffer.append(make_crange(std::string{ "ij" }));
+    ASSERT_EQ("fghij", to_string(gap_buffer));
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("fgh", to_string(gap_buffer));
+    ASSERT_TRUE(journal.redo(gap_buffer));
+    ASSERT_EQ("fghij", to_string(gap_buffer));
+
+    gap_buffer.remove(0, 2);
+    gap_buffer.append(make_crange(std::string{ "klm" }));
+    ASSERT_EQ("ijklm", to_string(gap_buffer));
+    ASSERT_EQ(1, journal.record_count());
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("ij", to_string(gap_buffer));
+    ASSERT_FALSE(journal.undo(gap_buffer));
+    ASSERT_TRUE(journal.redo(gap_buffer));
+    ASSERT_EQ("ijklm", to_string(gap_buffer));
+
+    // Under a lower limit, an undo that brings back more than fits trims
+    // the buffer again and the records along with it.
+    gap_buffer.remove(3, 2);
+    gap_buffer.set_size_limit(2);
+    ASSERT_EQ("jk", to_string(gap_buffer));
+    ASSERT_TRUE(journal.undo(gap_buffer));
+    ASSERT_EQ("lm", to_string(gap_buffer));
+    ASSERT_FALSE(journal.can_undo());
+    ASSERT_FALSE(journal.can_redo());
+    gap_buffer.remove_observer(&journal);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    const std::string alphabet = "ab\n";
+    std::uniform_int_distribution<> letter_distribution{ 0, static_cast<int>(alphabet.size()) - 1 };
+    std::uniform_int_distribution<> word_size_distribution{ 1, 12 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    GapBuffer<char> gap_buffer;
+    EditJournal<char> journal;
+    gap_buffer.add_observer(&journal);
+    std::vector<std::string> history = { "" };
+    for (auto count = 0; count < 500; ++count) {
+        const auto& content = history.back();
+        std::string word(word_size_distribution(random_engine), ' ');
+        for (auto& letter : word) {
+            letter = alphabet[letter_distribution(random_engine)];
+        }
+        std::uniform_int_distribution<> position_distribution{ 0, static_cast<int>(content.size()) };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 1, std::max(1, std::min(8, static_cast<int>(content.size()) - position)) };
+        auto next_content = content;
+        journal.begin_group();
+        if ((operation_distribution(random_engine) == 0) && (position < static_cast<int>(content.size()))) {
+            const auto remove_count = std::min(count_distribution(random_engine), static_cast<int>(content.size()) - position);
+            gap_buffer.remove(position, remove_count);
+            next_content.erase(position, remove_count);
+        } else {
+            type(gap_buffer, word, position);
+            next_content.insert(position, word);
+        }
+        journal.end_group();
+        history.push_back(next_content);
+    }
+    for (auto index = history.size() - 1; index > 0; --index) {
+        ASSERT_EQ(history[index], to_string(gap_buffer));
+        ASSERT_TRUE(journal.undo(gap_buffer));
+    }
+    ASSERT_EQ(history.front(), to_string(gap_buffer));
+    for (auto index = 1u; index < history.size(); ++index) {
+        ASSERT_TRUE(journal.redo(gap_buffer));
+        ASSERT_EQ(history[index], to_string(gap_buffer));
+    }
+    gap_buffer.remove_observer(&journal);
+}
+}
+}
+}
+}
+
+TEST(edit_journal, coalesce_typing) { cursor::test::edit_journal::coalesce_typing(); }
+
+TEST(edit_journal, new_edit_discards_redo) { cursor::test::edit_journal::new_edit_discards_redo(); }
+
+TEST(edit_journal, groups) { cursor::test::edit_journal::groups(); }
+
+TEST(edit_journal, splice_whole_buffer) { cursor::test::edit_journal::splice_whole_buffer(); }
+
+TEST(edit_journal, splice_strings) { cursor::test::edit_journal::splice_strings(); }
+
+TEST(edit_journal, size_limit) { cursor::test::edit_journal::size_limit(); }
+
+TEST(edit_journal, random_edits) { cursor::test::edit_journal::random_edits(); }
@@ -0,0 +1,191 @@
+#include "gap-buffer-io.hh"
+#include "gap-buffer.hh"
+#include "line-index.hh"
+#include "page-allocator.hh"
+#include "piece-table.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cursor {
+namespace test {
+namespace gap_buffer_io {
+namespace {
+
+class TemporaryFile {
+public:
+    explicit TemporaryFile(const std::string& content)
+    {
+        char path_template[] = "/tmp/gap-buffer-io-test-XXXXXX";
+        const auto descriptor = mkstemp(path_template);
+        close(descriptor);
+        path = path_template;
+        std::ofstream stream{ path, std::ios::binary };
+        stream << content;
+    }
+    ~TemporaryFile() { std::remove(path.c_str()); }
+    std::string path;
+};
+
+auto read_file(const std::string& path)
+{
+    std::ifstream stream{ path, std::ios::binary };
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+auto make_content(int size)
+{
+    std::string content;
+    for (auto offset = 0; offset < size; ++offset) {
+        content.push_back(((offset % 80) == 79) ? '\n' : static_cast<char>('a' + (offset % 26)));
+    }
+    return content;
+}
+
+template <typename GapBufferType> auto to_string(const GapBufferType& gap_buffer)
+{
+    return std::string(gap_buffer.cbegin(), gap_buffer.cend());
+}
+
+void load()
+{
+    const auto content = make_content(100000);
+    const TemporaryFile file{ content };
+    for (auto gap_position : { 0, 1, 5000, 99999, 100000 }) {
+        GapBuffer<char> gap_buffer;
+        io::load(gap_buffer, file.path, gap_position);
+        ASSERT_EQ(content, to_string(gap_buffer));
+        ASSERT_EQ(gap_position, gap_buffer.before_gap().size());
+    }
+}
+
+void load_notifies_observers()
+{
+    const auto content = make_content(1000);
+    const TemporaryFile file{ content };
+    GapBuffer<char> gap_buffer;
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    io::load(gap_buffer, file.path, 500);
+    ASSERT_EQ(13, line_index.line_count());
+    gap_buffer.remove_observer(&line_index);
+}
+
+void load_errors()
+{
+    const TemporaryFile file{ make_content(10) };
+    GapBuffer<char> gap_buffer;
+    ASSERT_THROW(io::load(gap_buffer, "/nonexistent/gap-buffer-io-test", 0), std::system_error);
+    ASSERT_THROW(io::load(gap_buffer, file.path, 11), std::out_of_range);
+}
+
+void save()
+{
+    const auto content = make_content(100000);
+    for (auto mode : { io::SaveMode::overwrite, io::SaveMode::atomic_replace }) {
+        for (auto gap_position : { 0, 5000, 100000 }) {
+            const TemporaryFile file{ "Old content" };
+            GapBuffer<char> gap_buffer;
+            gap_buffer.append(make_crange(content));
+            gap_buffer.remove(gap_position, 0);
+            io::save(gap_buffer, file.path, mode);
+            ASSERT_EQ(content, read_file(file.path));
+        }
+    }
+}
+
+void save_keeps_permissions()
+{
+    const TemporaryFile file{ "Old content" };
+    chmod(file.path.c_str(), 0640);
+    GapBuffer<char> gap_buffer;
+    const std::string content = "New content";
+    gap_buffer.append(make_crange(content));
+    io::save(gap_buffer, file.path);
+    struct stat status;
+    ASSERT_EQ(0, stat(file.path.c_str(), &status));
+    ASSERT_EQ(0640, status.st_mode & 07777);
+    ASSERT_EQ(content, read_file(file.path));
+}
+
+void save_errors()
+{
+    GapBuffer<char> gap_buffer;
+    ASSERT_THROW(io::save(gap_buffer, "/nonexistent/gap-buffer-io-test"), std::system_error);
+    ASSERT_THROW(io::save(gap_buffer, "/nonexistent/gap-buffer-io-test", io::SaveMode::overwrite), std::system_error);
+}
+
+void map()
+{
+    const auto content = make_content(100000);
+    const TemporaryFile file{ content };
+    GapBuffer<char, PageAllocator<char> > gap_buffer;
+    io::map(gap_buffer, file.path);
+    ASSERT_EQ(content, to_string(gap_buffer));
+
+    auto expected_content = content;
+    const std::string word = "Hello World!";
+    gap_buffer.insert(make_crange(word), 50000);
+    expected_content.insert(50000, word);
+    gap_buffer.remove(10, 20);
+    expected_content.erase(10, 20);
+    ASSERT_EQ(expected_content, to_string(gap_buffer));
+}
+
+void map_empty_file()
+{
+    const TemporaryFile file{ "" };
+    GapBuffer<char, PageAllocator<char> > gap_buffer;
+    io::map(gap_buffer, file.path);
+    ASSERT_EQ(0, gap_buffer.size());
+}
+
+void map_piece_table()
+{
+    const auto content = make_content(100000);
+    const TemporaryFile file{ content };
+    PieceTable<char> piece_table;
+    io::map(piece_table, file.path);
+    ASSERT_EQ(content, to_string(piece_table));
+
+    auto view = piece_table;
+    const std::string word = "Hello World!";
+    view.insert(make_crange(word), 50000);
+    view.remove(10, 20);
+    piece_table.clear();
+    auto expected_content = content;
+    expected_content.insert(50000, word);
+    expected_content.erase(10, 20);
+    ASSERT_EQ(expected_content, to_string(view));
+    ASSERT_EQ(0, piece_table.size());
+}
+}
+}
+}
+}
+
+TEST(gap_buffer_io, load) { cursor::test::gap_buffer_io::load(); }
+
+TEST(gap_buffer_io, load_notifies_observers) { cursor::test::gap_buffer_io::load_notifies_observers(); }
+
+TEST(gap_buffer_io, load_errors) { cursor::test::gap_buffer_io::load_errors(); }
+
+TEST(gap_buffer_io, save) { cursor::test::gap_buffer_io::save(); }
+
+TEST(gap_buffer_io, save_keeps_permissions) { cursor::test::gap_buffer_io::save_keeps_permissions(); }
+
+TEST(gap_buffer_io, save_errors) { cursor::test::gap_buffer_io::save_errors(); }
+
+TEST(gap_buffer_io, map) { cursor::test::gap_buffer_io::map(); }
+
+TEST(gap_buffer_io, map_empty_file) { cursor::test::gap_buffer_io::map_empty_file(); }
+
+TEST(gap_buffer_io, map_piece_table) { cursor::test::gap_buffer_io::map_piece_table(); }
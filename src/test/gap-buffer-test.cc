@@ -1,4 +1,7 @@
+#include "arena-allocator.hh"
 #include "gap-buffer.hh"
+#include "growth-policy.hh"
+#include "instrumentation.hh"
 #include "range.hh"
 
 #include <boost/format.hpp>
@@ -8,8 +11,12 @@
 #include <algorithm>
 #include <functional>
 #include <iterator>
+#if __cplusplus >= 201703L && __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
 #include <random>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 
@@ -774,6 +781,662 @@ void size()
     ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, content));
     ASSERT_EQ(content.size(), gap_buffer.size());
 }
+
+struct CountedElement {
+    CountedElement()
+        : value{ 0 }
+    {
+        instance_count += 1;
+    }
+    CountedElement(int value_)
+        : value{ value_ }
+    {
+        instance_count += 1;
+    }
+    CountedElement(const CountedElement& other)
+        : value{ other.value }
+    {
+        instance_count += 1;
+        copy_count += 1;
+    }
+    CountedElement(CountedElement&& other)
+        : value{ other.value }
+    {
+        other.value = -1;
+        instance_count += 1;
+    }
+    CountedElement& operator=(const CountedElement& other) = default;
+    CountedElement& operator=(CountedElement&& other) = default;
+    ~CountedElement() { instance_count -= 1; }
+    bool operator==(const CountedElement& other) const { return value == other.value; }
+    static int instance_count;
+    static int copy_count;
+    int value;
+};
+
+int CountedElement::instance_count = 0;
+int CountedElement::copy_count = 0;
+
+// Counts the elements held by all the allocators of an element type, to
+// check the storage a buffer keeps.
+template <typename Element> struct CountingAllocator {
+    using value_type = Element;
+
+    CountingAllocator() = default;
+    template <typename OtherElement> CountingAllocator(const CountingAllocator<OtherElement>&) {}
+
+    Element* allocate(std::size_t count)
+    {
+        allocated_count += count;
+        return std::allocator<Element>{}.allocate(count);
+    }
+    void deallocate(Element* elements, std::size_t count)
+    {
+        allocated_count -= count;
+        std::allocator<Element>{}.deallocate(elements, count);
+    }
+    bool operator==(const CountingAllocator&) const { return true; }
+    bool operator!=(const CountingAllocator&) const { return false; }
+
+    static std::ptrdiff_t allocated_count;
+};
+
+template <typename Element> std::ptrdiff_t CountingAllocator<Element>::allocated_count = 0;
+
+void non_trivial_elements()
+{
+    GapBuffer<std::string> gap_buffer;
+    std::vector<std::string> buffer;
+    const std::vector<std::string> words = { "Hello", "World", "Goodbye", "Moon" };
+    for (auto count = 0; count < 64; ++count) {
+        const auto position = (count * 7) % (gap_buffer.size() + 1);
+        gap_buffer.insert(make_crange(words), position);
+        buffer.insert(buffer.begin() + position, words.begin(), words.end());
+        if ((count % 3) == 0) {
+            gap_buffer.remove(position / 2, 2);
+            buffer.erase(buffer.begin() + position / 2, buffer.begin() + position / 2 + 2);
+        }
+        ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), gap_buffer.cbegin(), gap_buffer.cend()));
+    }
+}
+
+void element_lifetimes()
+{
+    CountedElement::instance_count = 0;
+    {
+        GapBuffer<CountedElement> gap_buffer;
+        const std::vector<CountedElement> elements = { 1, 2, 3, 4, 5 };
+        for (auto count = 0; count < 32; ++count) {
+            gap_buffer.insert(make_crange(elements), (count * 3) % (gap_buffer.size() + 1));
+            if ((count % 2) == 0) {
+                gap_buffer.remove(count % gap_buffer.size(), 1);
+            }
+            ASSERT_EQ(elements.size() + gap_buffer.size(), CountedElement::instance_count);
+            ASSERT_TRUE(std::none_of(gap_buffer.cbegin(), gap_buffer.cend(),
+                [](const CountedElement& element) { return element.value == -1; }));
+        }
+    }
+    ASSERT_EQ(0, CountedElement::instance_count);
+}
+
+void move_insert_and_emplace()
+{
+    CountedElement::instance_count = 0;
+    CountedElement::copy_count = 0;
+    {
+        GapBuffer<CountedElement> gap_buffer;
+        std::vector<CountedElement> elements = { 1, 2, 3, 4, 5 };
+        const auto copy_count = CountedElement::copy_count;
+        gap_buffer.move_insert(make_range(elements), 0);
+        ASSERT_TRUE(std::all_of(elements.begin(), elements.end(), [](const CountedElement& element) { return element.value == -1; }));
+        gap_buffer.emplace(2, 6);
+        gap_buffer.insert_at(0, CountedElement{ 7 });
+        gap_buffer.insert_in_place(gap_buffer.size(), 3, [](CountedElement* element, std::ptrdiff_t index) {
+            new (element) CountedElement{ 8 + static_cast<int>(index) };
+        });
+        ASSERT_EQ(copy_count, CountedElement::copy_count);
+        const std::vector<CountedElement> expected = { 7, 1, 2, 6, 3, 4, 5, 8, 9, 10 };
+        ASSERT_TRUE(std::equal(expected.begin(), expected.end(), gap_buffer.cbegin(), gap_buffer.cend()));
+        const CountedElement element{ 11 };
+        const auto element_copy_count = CountedElement::copy_count;
+        gap_buffer.insert_at(1, element);
+        ASSERT_EQ(element_copy_count + 1, CountedElement::copy_count);
+
+        ASSERT_THROW(gap_buffer.insert_in_place(0, 3, [](CountedElement* element, std::ptrdiff_t index) {
+            if (index == 2) {
+                throw std::runtime_error("Failed to construct");
+            }
+            new (element) CountedElement{ 12 };
+        }), std::runtime_error);
+        ASSERT_EQ(11, gap_buffer.size());
+        ASSERT_EQ(7, gap_buffer.cbegin()->value);
+        ASSERT_EQ(elements.size() + expected.size() + gap_buffer.size() + 1, CountedElement::instance_count);
+        ASSERT_THROW(gap_buffer.emplace(12, 1), std::out_of_range);
+    }
+    ASSERT_EQ(0, CountedElement::instance_count);
+}
+
+template <typename GapBufferType> void fill_gap_buffer(GapBufferType& gap_buffer, std::string& content)
+{
+    const std::string word = "Hello World!";
+    for (auto count = 0; count < 256; ++count) {
+        const auto position = (count * 13) % (gap_buffer.size() + 1);
+        gap_buffer.insert(make_crange(word), position);
+        content.insert(position, word);
+    }
+}
+
+template <typename GapBufferType> auto validate_content(const GapBufferType& gap_buffer, const std::string& content)
+{
+    const std::string gap_buffer_content(gap_buffer.cbegin(), gap_buffer.cend());
+    EXPECT_EQ(content, gap_buffer_content);
+    return content == gap_buffer_content;
+}
+
+void splice()
+{
+    std::mt19937 random_engine;
+    GapBuffer<char> destination;
+    GapBuffer<char> source;
+    std::string destination_content;
+    std::string source_content;
+    fill_gap_buffer(destination, destination_content);
+    fill_gap_buffer(source, source_content);
+    for (auto count = 0; count < 100; ++count) {
+        std::uniform_int_distribution<> source_position_distribution{ 0, static_cast<int>(source.size()) };
+        const auto source_position = source_position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(200, static_cast<int>(source.size()) - source_position) };
+        const auto splice_count = count_distribution(random_engine);
+        std::uniform_int_distribution<> position_distribution{ 0, static_cast<int>(destination.size()) };
+        const auto position = position_distribution(random_engine);
+        destination.splice(position, source, source_position, splice_count);
+        destination_content.insert(position, source_content, source_position, splice_count);
+        source_content.erase(source_position, splice_count);
+        ASSERT_TRUE(validate_content(destination, destination_content));
+        ASSERT_TRUE(validate_content(source, source_content));
+        std::swap(destination, source);
+        std::swap(destination_content, source_content);
+    }
+    ASSERT_THROW(destination.splice(0, source, source.size(), 1), std::out_of_range);
+    ASSERT_THROW(destination.splice(destination.size() + 1, source, 0, 0), std::out_of_range);
+    ASSERT_THROW(destination.splice(0, destination, 0, 1), std::invalid_argument);
+
+    GapBuffer<char> empty;
+    const auto source_snapshot = source.snapshot();
+    empty.splice(0, source);
+    ASSERT_TRUE(validate_content(empty, source_content));
+    ASSERT_EQ(0, source.size());
+    ASSERT_TRUE(std::equal(source_content.begin(), source_content.end(), source_snapshot.cbegin(), source_snapshot.cend()));
+
+    CountedElement::instance_count = 0;
+    CountedElement::copy_count = 0;
+    {
+        GapBuffer<CountedElement> counted_destination;
+        GapBuffer<CountedElement> counted_source;
+        const std::vector<CountedElement> destination_elements = { 1, 2, 3 };
+        const std::vector<CountedElement> source_elements = { 4, 5, 6, 7, 8 };
+        counted_destination.insert(make_crange(destination_elements), 0);
+        counted_source.insert(make_crange(source_elements), 0);
+        counted_source.remove(2, 0);
+        const auto counted_snapshot = counted_source.snapshot();
+        const auto copy_count = CountedElement::copy_count;
+        const auto first = std::next(counted_source.cbegin());
+        counted_destination.splice(1, counted_source, make_range(first, std::next(first, 3)));
+        ASSERT_EQ(copy_count + 5, CountedElement::copy_count);
+        const std::vector<CountedElement> expected = { 1, 5, 6, 7, 2, 3 };
+        ASSERT_TRUE(std::equal(expected.begin(), expected.end(), counted_destination.cbegin(), counted_destination.cend()));
+        const std::vector<CountedElement> expected_source = { 4, 8 };
+        ASSERT_TRUE(std::equal(expected_source.begin(), expected_source.end(), counted_source.cbegin(), counted_source.cend()));
+        ASSERT_EQ(5, counted_snapshot.size());
+        ASSERT_EQ(6, std::next(counted_snapshot.cbegin(), 2)->value);
+    }
+    ASSERT_EQ(0, CountedElement::instance_count);
+}
+
+void size_limit()
+{
+    GapBuffer<char, std::allocator<char>, DoublingGrowthPolicy, CountingInstrumentation> gap_buffer;
+    gap_buffer.set_size_limit(1000);
+    std::string content;
+    const std::string line = "Hello World!\n";
+    const auto trim = [&content]() {
+        if (content.size() > 1000) {
+            content.erase(0, content.size() - 1000);
+        }
+    };
+    for (auto count = 0; count < 10000; ++count) {
+        gap_buffer.append(make_crange(line));
+        content += line;
+        trim();
+        if ((count % 1000) == 0) {
+            gap_buffer.insert(make_crange(line), 10);
+            content.insert(10, line);
+            trim();
+        }
+        if ((count % 100) == 0) {
+            ASSERT_TRUE(validate_content(gap_buffer, content));
+        }
+    }
+    ASSERT_TRUE(validate_content(gap_buffer, content));
+    // Once the storage is twice the limit, the storage that dropped elements
+    // leave at the front is reused rather than reallocated.
+    ASSERT_LE(gap_buffer.get_instrumentation().snapshot().reallocations, 12u);
+    ASSERT_LE(gap_buffer.get_instrumentation().snapshot().peak_capacity, 4096);
+
+    const auto snapshot = gap_buffer.snapshot();
+    gap_buffer.append(make_crange(line));
+    ASSERT_TRUE(std::equal(content.begin(), content.end(), snapshot.cbegin(), snapshot.cend()));
+    content = (content + line).substr(line.size());
+    ASSERT_TRUE(validate_content(gap_buffer, content));
+    gap_buffer.set_size_limit(10);
+    ASSERT_TRUE(validate_content(gap_buffer, content.substr(content.size() - 10)));
+    gap_buffer.set_size_limit(0);
+    gap_buffer.append(make_crange(content));
+    ASSERT_EQ(10 + content.size(), gap_buffer.size());
+    ASSERT_THROW(gap_buffer.set_size_limit(-1), std::out_of_range);
+
+    // shrink_to_fit also releases the storage that dropped elements left at
+    // the front, when there is no gap left to release.
+    {
+        GapBuffer<char, CountingAllocator<char> > trimmed_buffer;
+        trimmed_buffer.append(make_crange(content));
+        trimmed_buffer.shrink_to_fit();
+        trimmed_buffer.set_size_limit(10);
+        ASSERT_EQ(content.size(), CountingAllocator<char>::allocated_count);
+        trimmed_buffer.shrink_to_fit();
+        ASSERT_EQ(10, CountingAllocator<char>::allocated_count);
+        ASSERT_EQ(10, trimmed_buffer.capacity());
+        ASSERT_TRUE(validate_content(trimmed_buffer, content.substr(content.size() - 10)));
+    }
+    ASSERT_EQ(0, CountingAllocator<char>::allocated_count);
+
+    CountedElement::instance_count = 0;
+    {
+        GapBuffer<CountedElement> counted_buffer;
+        counted_buffer.set_size_limit(5);
+        for (auto value = 0; value < 100; ++value) {
+            counted_buffer.emplace(counted_buffer.size(), value);
+        }
+        const std::vector<CountedElement> expected = { 95, 96, 97, 98, 99 };
+        ASSERT_TRUE(std::equal(expected.begin(), expected.end(), counted_buffer.cbegin(), counted_buffer.cend()));
+        ASSERT_EQ(10, CountedElement::instance_count);
+    }
+    ASSERT_EQ(0, CountedElement::instance_count);
+}
+
+void growth_policies()
+{
+    {
+        GapBuffer<char, std::allocator<char>, OneAndAHalfGrowthPolicy> gap_buffer;
+        std::string content;
+        fill_gap_buffer(gap_buffer, content);
+        ASSERT_TRUE(validate_content(gap_buffer, content));
+        ASSERT_LE(gap_buffer.capacity(), (gap_buffer.size() * 3) / 2 + 1);
+    }
+    {
+        const auto chunk_size = 1000;
+        GapBuffer<char, std::allocator<char>, FixedChunkGrowthPolicy<chunk_size> > gap_buffer;
+        std::string content;
+        fill_gap_buffer(gap_buffer, content);
+        ASSERT_TRUE(validate_content(gap_buffer, content));
+        ASSERT_EQ(0, gap_buffer.capacity() % chunk_size);
+        ASSERT_LE(gap_buffer.capacity(), gap_buffer.size() + chunk_size);
+    }
+    {
+        GapBuffer<char, std::allocator<char>, GapProportionalGrowthPolicy<1, 8> > gap_buffer;
+        std::string content;
+        fill_gap_buffer(gap_buffer, content);
+        ASSERT_TRUE(validate_content(gap_buffer, content));
+        ASSERT_LE(gap_buffer.capacity(), gap_buffer.size() + gap_buffer.size() / 8 + 64);
+    }
+}
+
+void arena_allocator()
+{
+    using ArenaGapBuffer = GapBuffer<char, ArenaAllocator<char> >;
+    Arena arena{ 4096 };
+    std::vector<ArenaGapBuffer> gap_buffers;
+    std::vector<std::string> contents;
+    for (auto count = 0; count < 1000; ++count) {
+        gap_buffers.emplace_back(ArenaAllocator<char>{ arena });
+        contents.emplace_back();
+        const std::string word(count % 100, static_cast<char>('a' + count % 26));
+        gap_buffers.back().append(make_crange(word));
+        contents.back().append(word);
+    }
+    for (auto index = 0; index < static_cast<int>(gap_buffers.size()); ++index) {
+        gap_buffers[index].insert(make_crange(contents[index]), index % (gap_buffers[index].size() + 1));
+        contents[index].insert(index % (contents[index].size() + 1), contents[index]);
+        ASSERT_TRUE(validate_content(gap_buffers[index], contents[index]));
+    }
+    ArenaGapBuffer moved_gap_buffer{ std::move(gap_buffers.front()) };
+    ASSERT_TRUE(validate_content(moved_gap_buffer, contents.front()));
+    ASSERT_EQ(0, gap_buffers.front().size());
+}
+
+void reserve()
+{
+    GapBuffer<char> gap_buffer;
+    std::string content = "Hello World!";
+    gap_buffer.reserve(1000);
+    ASSERT_EQ(1000, gap_buffer.capacity());
+    gap_buffer.append(make_crange(content));
+    gap_buffer.insert(make_crange(content), 5);
+    content.insert(5, content);
+    ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, content));
+    ASSERT_EQ(1000, gap_buffer.capacity());
+    gap_buffer.reserve(10);
+    ASSERT_EQ(1000, gap_buffer.capacity());
+}
+
+void shrink_to_fit()
+{
+    GapBuffer<char> gap_buffer;
+    std::string content(1 << 16, 'a');
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(10, content.size() - 20);
+    content.erase(10, content.size() - 20);
+    gap_buffer.shrink_to_fit();
+    ASSERT_EQ(gap_buffer.size(), gap_buffer.capacity());
+    ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, content));
+    gap_buffer.clear();
+    gap_buffer.shrink_to_fit();
+    ASSERT_EQ(0, gap_buffer.capacity());
+}
+
+void shrink_policy()
+{
+    GapBuffer<char> gap_buffer;
+    gap_buffer.set_shrink_policy(ShrinkPolicy{ 1.0, 0.25, 1024 });
+    std::string content(1 << 20, 'a');
+    gap_buffer.append(make_crange(content));
+    const auto grown_capacity = gap_buffer.capacity();
+
+    gap_buffer.remove(0, (1 << 20) - 4096);
+    content.erase(0, (1 << 20) - 4096);
+    ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, content));
+    ASSERT_LT(gap_buffer.capacity(), grown_capacity);
+    ASSERT_LE(gap_buffer.capacity(), 4096 + 1024);
+
+    const auto shrunk_capacity = gap_buffer.capacity();
+    const std::string word = "Hello";
+    gap_buffer.insert(make_crange(word), 100);
+    gap_buffer.remove(100, word.size());
+    ASSERT_EQ(shrunk_capacity, gap_buffer.capacity());
+
+    gap_buffer.clear();
+    ASSERT_EQ(0, gap_buffer.capacity());
+}
+
+void polymorphic_allocator()
+{
+#if __cplusplus >= 201703L && __has_include(<memory_resource>)
+    std::pmr::monotonic_buffer_resource resource;
+    GapBuffer<char, std::pmr::polymorphic_allocator<char> > gap_buffer{ &resource };
+    std::string content;
+    fill_gap_buffer(gap_buffer, content);
+    ASSERT_TRUE(validate_content(gap_buffer, content));
+
+    std::pmr::monotonic_buffer_resource other_resource;
+    GapBuffer<char, std::pmr::polymorphic_allocator<char> > other_gap_buffer{ &other_resource };
+    other_gap_buffer = std::move(gap_buffer);
+    ASSERT_TRUE(validate_content(other_gap_buffer, content));
+    ASSERT_EQ(&other_resource, other_gap_buffer.get_allocator().resource());
+#endif
+}
+
+void apply_edits()
+{
+    std::mt19937 random_engine;
+    std::string content(10000, 'a');
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(5000, 0);
+
+    std::vector<std::string> words;
+    std::vector<Edit<Range<std::string::const_iterator> > > edits;
+    std::uniform_int_distribution<> word_size_distribution{ 0, 40 };
+    std::uniform_int_distribution<> count_distribution{ 0, 20 };
+    words.reserve(200);
+    for (auto position = 0; position < static_cast<int>(content.size()) - 20; position += 50) {
+        words.push_back(std::string(word_size_distribution(random_engine), 'b'));
+        edits.push_back(make_edit(position, count_distribution(random_engine), make_crange(words.back())));
+    }
+    std::shuffle(edits.begin(), edits.end(), random_engine);
+
+    auto expected_content = content;
+    auto sorted_edits = edits;
+    std::sort(sorted_edits.begin(), sorted_edits.end(), [](const auto& lhs, const auto& rhs) { return lhs.position > rhs.position; });
+    for (const auto& edit : sorted_edits) {
+        expected_content.replace(edit.position, edit.count, std::string(edit.insert_range.begin(), edit.insert_range.end()));
+    }
+
+    const auto positions = gap_buffer.apply_edits(edits);
+    ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, expected_content));
+    ASSERT_EQ(edits.size(), positions.size());
+    for (auto index = 0u; index < edits.size(); ++index) {
+        const auto& insert_range = edits[index].insert_range;
+        ASSERT_TRUE(std::equal(insert_range.begin(), insert_range.end(), gap_buffer.cbegin() + positions[index]));
+    }
+
+    const std::string word = "Hello";
+    const std::vector<Edit<Range<std::string::const_iterator> > > overlapping_edits
+        = { make_edit(10, 5, make_crange(word)), make_edit(12, 0, make_crange(word)) };
+    ASSERT_THROW(gap_buffer.apply_edits(overlapping_edits), std::out_of_range);
+    ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, expected_content));
+
+    const std::vector<Edit<Range<std::string::const_iterator> > > same_position_edits
+        = { make_edit(0, 0, make_crange(word)), make_edit(0, 0, make_crange(content)) };
+    gap_buffer.apply_edits(same_position_edits);
+    ASSERT_TRUE(validate_gap_buffer_content(gap_buffer, word + content + expected_content));
+}
+
+template <typename Content> auto to_string(const Content& content)
+{
+    return std::string(content.cbegin(), content.cend());
+}
+
+void iterator_arithmetic()
+{
+    GapBuffer<char> gap_buffer;
+    std::string content;
+    for (auto count = 0; count < 100; ++count) {
+        content.push_back(static_cast<char>('a' + (count % 26)));
+    }
+    gap_buffer.append(make_crange(content));
+    for (auto gap_position : { 0, 1, 50, 99, 100 }) {
+        gap_buffer.remove(gap_position, 0);
+        const auto begin = gap_buffer.cbegin();
+        const auto end = gap_buffer.cend();
+        ASSERT_EQ(100, end - begin);
+        for (auto first : { 0, 1, 49, 50, 51, 99, 100 }) {
+            for (auto last : { 0, 1, 49, 50, 51, 99, 100 }) {
+                auto element = begin + first;
+                ASSERT_EQ(last - first, (begin + last) - element);
+                element += last - first;
+                ASSERT_EQ(begin + last, element);
+                element -= last - first;
+                ASSERT_EQ(first, element - begin);
+                if (last < 100) {
+                    ASSERT_EQ(content[last], begin[last]);
+                    ASSERT_EQ(content[last], *((end - 100) + last));
+                }
+            }
+        }
+        GapBuffer<char>::const_iterator element = gap_buffer.begin();
+        ASSERT_EQ(gap_buffer.cbegin(), element);
+    }
+}
+
+void view()
+{
+    GapBuffer<char> gap_buffer;
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(5, 0);
+    auto to_string = [](Range<const char*> view) { return std::string(view.begin(), view.end()); };
+    ASSERT_EQ("Hello", to_string(gap_buffer.view(0, 5)));
+    ASSERT_EQ(" World", to_string(gap_buffer.view(5, 6)));
+    ASSERT_EQ(gap_buffer.before_gap().begin(), gap_buffer.view(0, 5).begin());
+
+    ASSERT_EQ("lo Wo", to_string(gap_buffer.view(3, 5, ViewPolicy::copy)));
+    ASSERT_EQ(5, gap_buffer.before_gap().size());
+    ASSERT_EQ("lo Wo", to_string(gap_buffer.view(3, 5)));
+    ASSERT_EQ(3, gap_buffer.before_gap().size());
+    ASSERT_EQ("Hell", to_string(gap_buffer.view(0, 4)));
+    ASSERT_EQ(4, gap_buffer.before_gap().size());
+
+    ASSERT_EQ(content, to_string(gap_buffer.linearize()));
+    ASSERT_EQ(0, gap_buffer.before_gap().size());
+    ASSERT_THROW(gap_buffer.view(5, 7), std::out_of_range);
+    ASSERT_THROW(gap_buffer.view(-1, 2), std::out_of_range);
+    ASSERT_EQ(0, gap_buffer.view(11, 0).size());
+
+    // The copy of a range across the gap comes from the allocator of the
+    // buffer.
+    {
+        GapBuffer<char, CountingAllocator<char> > counted_buffer;
+        counted_buffer.append(make_crange(content));
+        counted_buffer.remove(5, 0);
+        ASSERT_EQ(counted_buffer.capacity(), CountingAllocator<char>::allocated_count);
+        ASSERT_EQ("lo Wo", to_string(counted_buffer.view(3, 5, ViewPolicy::copy)));
+        ASSERT_LE(counted_buffer.capacity() + 5, CountingAllocator<char>::allocated_count);
+    }
+    ASSERT_EQ(0, CountingAllocator<char>::allocated_count);
+}
+
+#if CURSOR_CHECKED_ITERATORS
+void checked_iterators()
+{
+    GapBuffer<char> gap_buffer;
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    auto element = gap_buffer.cbegin() + 5;
+    ASSERT_EQ(' ', *element);
+    gap_buffer.insert(make_crange(std::string(",")), 5);
+    ASSERT_THROW(*element, std::logic_error);
+    ASSERT_THROW(++element, std::logic_error);
+
+    GapBuffer<char> other_gap_buffer;
+    other_gap_buffer.append(make_crange(content));
+    ASSERT_THROW(gap_buffer.cbegin() == other_gap_buffer.cbegin(), std::logic_error);
+
+    auto snapshot = gap_buffer.snapshot();
+    auto snapshot_element = snapshot.cbegin();
+    gap_buffer.clear();
+    ASSERT_EQ('H', *snapshot_element);
+}
+#endif
+
+void snapshot()
+{
+    GapBuffer<char> gap_buffer;
+    ASSERT_EQ(0, gap_buffer.snapshot().size());
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(5, 0);
+
+    auto snapshot = gap_buffer.snapshot();
+    ASSERT_EQ(content, to_string(snapshot));
+    ASSERT_EQ(gap_buffer.cbegin().operator->(), snapshot.cbegin().operator->());
+
+    const std::string word = ",";
+    gap_buffer.insert(make_crange(word), 5);
+    ASSERT_EQ(content, to_string(snapshot));
+    ASSERT_EQ("Hello, World", to_string(gap_buffer));
+    ASSERT_NE(gap_buffer.before_gap().begin(), snapshot.before_gap().begin());
+
+    auto other_snapshot = gap_buffer.snapshot();
+    gap_buffer = GapBuffer<char>{};
+    ASSERT_EQ("Hello, World", to_string(other_snapshot));
+    ASSERT_EQ(content, to_string(snapshot));
+}
+
+void snapshot_storage_is_reclaimed()
+{
+    GapBuffer<char> gap_buffer;
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    const auto storage = gap_buffer.cbegin().operator->();
+    gap_buffer.snapshot();
+    const std::string word = "!";
+    gap_buffer.append(make_crange(word));
+    ASSERT_EQ(storage, gap_buffer.cbegin().operator->());
+    ASSERT_EQ("Hello World!", to_string(gap_buffer));
+}
+
+void snapshot_non_trivial_elements()
+{
+    GapBuffer<std::string> gap_buffer;
+    const std::vector<std::string> words = { "Hello", "World" };
+    gap_buffer.append(make_crange(words));
+    auto snapshot = gap_buffer.snapshot();
+    gap_buffer.remove(0, 1);
+    ASSERT_EQ(2, snapshot.size());
+    ASSERT_EQ("Hello", *snapshot.cbegin());
+    ASSERT_EQ(1, gap_buffer.size());
+    ASSERT_EQ("World", *gap_buffer.cbegin());
+}
+
+void snapshot_concurrent_reader()
+{
+    GapBuffer<char> gap_buffer;
+    std::string content(1 << 16, 'a');
+    gap_buffer.append(make_crange(content));
+    std::vector<std::string> expected_contents;
+    std::vector<GapBuffer<char>::snapshot_type> snapshots;
+    const std::string word = "b";
+    for (auto count = 0; count < 20; ++count) {
+        snapshots.push_back(gap_buffer.snapshot());
+        expected_contents.push_back(content);
+        gap_buffer.insert(make_crange(word), count * 100);
+        content.insert(count * 100, word);
+    }
+    auto is_consistent = true;
+    std::thread reader{ [&snapshots, &expected_contents, &is_consistent]() {
+        for (auto index = 0u; index < snapshots.size(); ++index) {
+            is_consistent = is_consistent && (to_string(snapshots[index]) == expected_contents[index]);
+        }
+    } };
+    for (auto count = 0; count < 1000; ++count) {
+        gap_buffer.insert(make_crange(word), (count * 37) % gap_buffer.size());
+    }
+    reader.join();
+    ASSERT_TRUE(is_consistent);
+}
+
+void instrumentation()
+{
+    using InstrumentedGapBuffer = GapBuffer<char, std::allocator<char>, DoublingGrowthPolicy, CountingInstrumentation>;
+    InstrumentedGapBuffer gap_buffer;
+    gap_buffer.get_instrumentation() = CountingInstrumentation{ 1 };
+    const std::string content = "Hello World!";
+    gap_buffer.reserve(16);
+    gap_buffer.append(make_crange(content));
+    gap_buffer.insert(make_crange(content), 5);
+    gap_buffer.remove(0, 4);
+    gap_buffer.replace(10, 2, make_crange(std::string("!")));
+    const auto snapshot = gap_buffer.get_instrumentation().snapshot();
+    ASSERT_EQ(3u, snapshot.insertions);
+    ASSERT_EQ(2u, snapshot.removals);
+    ASSERT_EQ(2u, snapshot.reallocations);
+    ASSERT_EQ(32, snapshot.peak_capacity);
+    ASSERT_EQ(3u, snapshot.gap_moves);
+    ASSERT_EQ(3u, snapshot.gap_move_distances.total());
+    ASSERT_EQ(1u, snapshot.gap_move_distances.counts[Log2Histogram::bucket_of(7)]);
+    ASSERT_EQ(7u + 12u + 17u + 10u, snapshot.bytes_moved);
+    ASSERT_EQ(4u, snapshot.edit_latencies.total());
+    ASSERT_LE(snapshot.edit_latencies.quantile_limit(0.5), snapshot.edit_latencies.quantile_limit(1.0));
+
+    gap_buffer.get_instrumentation() = CountingInstrumentation{ 2 };
+    ASSERT_EQ(0u, gap_buffer.get_instrumentation().snapshot().insertions);
+    ASSERT_EQ(0u, gap_buffer.get_instrumentation().snapshot().edit_latencies.quantile_limit(0.99));
+    for (auto count = 0; count < 10; ++count) {
+        gap_buffer.append(make_crange(content));
+    }
+    ASSERT_EQ(10u, gap_buffer.get_instrumentation().snapshot().insertions);
+    ASSERT_EQ(5u, gap_buffer.get_instrumentation().snapshot().edit_latencies.total());
+}
 }
 }
 }
@@ -794,6 +1457,48 @@ TEST(gap_buffer, replace_at_iterator) { cursor::test::gap_buffer::replace_at_ite
 
 TEST(gap_buffer, size) { cursor::test::gap_buffer::size(); }
 
+TEST(gap_buffer, non_trivial_elements) { cursor::test::gap_buffer::non_trivial_elements(); }
+
+TEST(gap_buffer, element_lifetimes) { cursor::test::gap_buffer::element_lifetimes(); }
+
+TEST(gap_buffer, move_insert_and_emplace) { cursor::test::gap_buffer::move_insert_and_emplace(); }
+
+TEST(gap_buffer, splice) { cursor::test::gap_buffer::splice(); }
+
+TEST(gap_buffer, size_limit) { cursor::test::gap_buffer::size_limit(); }
+
+TEST(gap_buffer, growth_policies) { cursor::test::gap_buffer::growth_policies(); }
+
+TEST(gap_buffer, arena_allocator) { cursor::test::gap_buffer::arena_allocator(); }
+
+TEST(gap_buffer, reserve) { cursor::test::gap_buffer::reserve(); }
+
+TEST(gap_buffer, shrink_to_fit) { cursor::test::gap_buffer::shrink_to_fit(); }
+
+TEST(gap_buffer, shrink_policy) { cursor::test::gap_buffer::shrink_policy(); }
+
+TEST(gap_buffer, polymorphic_allocator) { cursor::test::gap_buffer::polymorphic_allocator(); }
+
+TEST(gap_buffer, apply_edits) { cursor::test::gap_buffer::apply_edits(); }
+
+TEST(gap_buffer, iterator_arithmetic) { cursor::test::gap_buffer::iterator_arithmetic(); }
+
+TEST(gap_buffer, view) { cursor::test::gap_buffer::view(); }
+
+#if CURSOR_CHECKED_ITERATORS
+TEST(gap_buffer, checked_iterators) { cursor::test::gap_buffer::checked_iterators(); }
+#endif
+
+TEST(gap_buffer, instrumentation) { cursor::test::gap_buffer::instrumentation(); }
+
+TEST(gap_buffer, snapshot) { cursor::test::gap_buffer::snapshot(); }
+
+TEST(gap_buffer, snapshot_storage_is_reclaimed) { cursor::test::gap_buffer::snapshot_storage_is_reclaimed(); }
+
+TEST(gap_buffer, snapshot_non_trivial_elements) { cursor::test::gap_buffer::snapshot_non_trivial_elements(); }
+
+TEST(gap_buffer, snapshot_concurrent_reader) { cursor::test::gap_buffer::snapshot_concurrent_reader(); }
+
 TEST(random_word_generator, generate_random_words) { cursor::test::gap_buffer::generate_random_words(); }
 
 TEST(gap_buffer, random_buffer_modifications) { cursor::test::gap_buffer::random_buffer_modifications(); }
@@ -0,0 +1,165 @@
+#include "gap-buffer.hh"
+#include "line-index.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace line_index {
+namespace {
+
+auto line_starts(const std::string& content)
+{
+    std::vector<std::ptrdiff_t> starts = { 0 };
+    for (auto offset = 0; offset < static_cast<int>(content.size()); ++offset) {
+        if (content[offset] == '\n') {
+            starts.push_back(offset + 1);
+        }
+    }
+    return starts;
+}
+
+auto validate_line_index(const LineIndex<char>& line_index, const std::string& content)
+{
+    const auto starts = line_starts(content);
+    EXPECT_EQ(static_cast<std::ptrdiff_t>(starts.size()), line_index.line_count());
+    if (static_cast<std::ptrdiff_t>(starts.size()) != line_index.line_count()) {
+        return false;
+    }
+    for (auto line = 0; line < static_cast<int>(starts.size()); ++line) {
+        EXPECT_EQ(starts[line], line_index.line_to_offset(line));
+        if (starts[line] != line_index.line_to_offset(line)) {
+            return false;
+        }
+    }
+    auto line = 0;
+    for (auto offset = 0; offset <= static_cast<int>(content.size()); ++offset) {
+        if ((line + 1 < static_cast<int>(starts.size())) && (starts[line + 1] == offset)) {
+            line += 1;
+        }
+        EXPECT_EQ(line, line_index.offset_to_line(offset));
+        if (line != line_index.offset_to_line(offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void attach_to_content()
+{
+    GapBuffer<char> gap_buffer;
+    const std::string content = "Hello\nWorld\n\nGoodbye";
+    gap_buffer.append(make_crange(content));
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    ASSERT_EQ(4, line_index.line_count());
+    ASSERT_TRUE(validate_line_index(line_index, content));
+    gap_buffer.remove_observer(&line_index);
+}
+
+void invalid_lookups()
+{
+    GapBuffer<char> gap_buffer;
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    const std::string content = "Hello\nWorld";
+    gap_buffer.append(make_crange(content));
+    ASSERT_THROW(line_index.line_to_offset(2), std::out_of_range);
+    ASSERT_THROW(line_index.line_to_offset(-1), std::out_of_range);
+    ASSERT_THROW(line_index.offset_to_line(12), std::out_of_range);
+    gap_buffer.remove_observer(&line_index);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    const std::string alphabet = "ab\n";
+    std::uniform_int_distribution<> letter_distribution{ 0, static_cast<int>(alphabet.size()) - 1 };
+    std::uniform_int_distribution<> word_size_distribution{ 0, 12 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    GapBuffer<char> gap_buffer;
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    std::string content;
+    for (auto count = 0; count < 2000; ++count) {
+        std::string word(word_size_distribution(random_engine), ' ');
+        for (auto& letter : word) {
+            letter = alphabet[letter_distribution(random_engine)];
+        }
+        std::uniform_int_distribution<> position_distribution{ 0, static_cast<int>(content.size()) };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(8, static_cast<int>(content.size()) - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0:
+            gap_buffer.insert(make_crange(word), position);
+            content.insert(position, word);
+            break;
+        case 1:
+            gap_buffer.remove(position, remove_count);
+            content.erase(position, remove_count);
+            break;
+        default:
+            gap_buffer.replace(position, remove_count, make_crange(word));
+            content.replace(position, remove_count, word);
+            break;
+        }
+        if ((count % 50) == 0) {
+            ASSERT_TRUE(validate_line_index(line_index, content));
+        }
+    }
+    ASSERT_TRUE(validate_line_index(line_index, content));
+    gap_buffer.remove_observer(&line_index);
+}
+
+void size_limit()
+{
+    std::mt19937 random_engine;
+    const std::string alphabet = "ab\n";
+    std::uniform_int_distribution<> letter_distribution{ 0, static_cast<int>(alphabet.size()) - 1 };
+    std::uniform_int_distribution<> word_size_distribution{ 0, 40 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 9 };
+    const auto limit = 200;
+    GapBuffer<char> gap_buffer;
+    gap_buffer.set_size_limit(limit);
+    LineIndex<char> line_index;
+    gap_buffer.add_observer(&line_index);
+    std::string content;
+    for (auto count = 0; count < 2000; ++count) {
+        std::string word(word_size_distribution(random_engine), ' ');
+        for (auto& letter : word) {
+            letter = alphabet[letter_distribution(random_engine)];
+        }
+        // Most edits append, as to a tailed log, and some insert elsewhere.
+        std::uniform_int_distribution<> position_distribution{ 0, static_cast<int>(content.size()) };
+        const auto position = (operation_distribution(random_engine) == 0) ? position_distribution(random_engine)
+                                                                            : static_cast<int>(content.size());
+        gap_buffer.insert(make_crange(word), position);
+        content.insert(position, word);
+        if (static_cast<int>(content.size()) > limit) {
+            content.erase(0, content.size() - limit);
+        }
+        if ((count % 50) == 0) {
+            ASSERT_TRUE(validate_line_index(line_index, content));
+        }
+    }
+    ASSERT_TRUE(validate_line_index(line_index, content));
+    gap_buffer.remove_observer(&line_index);
+}
+}
+}
+}
+}
+
+TEST(line_index, attach_to_content) { cursor::test::line_index::attach_to_content(); }
+
+TEST(line_index, invalid_lookups) { cursor::test::line_index::invalid_lookups(); }
+
+TEST(line_index, random_edits) { cursor::test::line_index::random_edits(); }
+
+TEST(line_index, size_limit) { cursor::test::line_index::size_limit(); }
@@ -0,0 +1,142 @@
+#include "gap-buffer.hh"
+#include "mark-set.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace mark_set {
+namespace {
+
+struct ExpectedMark {
+    MarkSet<char>::mark_type mark;
+    std::ptrdiff_t position;
+    Gravity gravity;
+};
+
+void insert(std::vector<ExpectedMark>& marks, std::ptrdiff_t position, std::ptrdiff_t count)
+{
+    for (auto& mark : marks) {
+        if ((mark.position > position) || ((mark.position == position) && (mark.gravity == Gravity::right))) {
+            mark.position += count;
+        }
+    }
+}
+
+void remove(std::vector<ExpectedMark>& marks, std::ptrdiff_t position, std::ptrdiff_t count)
+{
+    for (auto& mark : marks) {
+        if (mark.position > (position + count)) {
+            mark.position -= count;
+        } else if (mark.position > position) {
+            mark.position = position;
+        }
+    }
+}
+
+void gravity()
+{
+    GapBuffer<char> gap_buffer;
+    MarkSet<char> mark_set;
+    gap_buffer.add_observer(&mark_set);
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    const auto left = mark_set.add(5, Gravity::left);
+    const auto right = mark_set.add(5, Gravity::right);
+    const auto end = mark_set.add(11);
+    const std::string word = ",";
+    gap_buffer.insert(make_crange(word), 5);
+    ASSERT_EQ(5, mark_set.position(left));
+    ASSERT_EQ(6, mark_set.position(right));
+    ASSERT_EQ(12, mark_set.position(end));
+    gap_buffer.remove(2, 8);
+    ASSERT_EQ(2, mark_set.position(left));
+    ASSERT_EQ(2, mark_set.position(right));
+    ASSERT_EQ(4, mark_set.position(end));
+    gap_buffer.remove_observer(&mark_set);
+}
+
+void add_and_remove()
+{
+    GapBuffer<char> gap_buffer;
+    MarkSet<char> mark_set;
+    gap_buffer.add_observer(&mark_set);
+    const std::string content = "Hello World";
+    gap_buffer.append(make_crange(content));
+    const auto first = mark_set.add(3);
+    const auto second = mark_set.add(7, Gravity::right);
+    ASSERT_EQ(2, mark_set.size());
+    mark_set.remove(first);
+    ASSERT_EQ(1, mark_set.size());
+    ASSERT_THROW(mark_set.position(first), std::out_of_range);
+    ASSERT_THROW(mark_set.add(12), std::out_of_range);
+    mark_set.set_position(second, 1);
+    ASSERT_EQ(1, mark_set.position(second));
+    ASSERT_EQ(Gravity::right, mark_set.gravity(second));
+    gap_buffer.clear();
+    ASSERT_EQ(0, mark_set.position(second));
+    gap_buffer.remove_observer(&mark_set);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> word_size_distribution{ 0, 12 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 3 };
+    std::uniform_int_distribution<> gravity_distribution{ 0, 1 };
+    GapBuffer<char> gap_buffer;
+    MarkSet<char> mark_set;
+    gap_buffer.add_observer(&mark_set);
+    const std::string content(100, 'a');
+    gap_buffer.append(make_crange(content));
+    std::vector<ExpectedMark> marks;
+    for (auto count = 0; count < 2000; ++count) {
+        const auto content_size = static_cast<int>(gap_buffer.size());
+        const std::string word(word_size_distribution(random_engine), 'b');
+        std::uniform_int_distribution<> position_distribution{ 0, content_size };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(8, content_size - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0: {
+            const auto gravity = (gravity_distribution(random_engine) == 0) ? Gravity::left : Gravity::right;
+            marks.push_back({ mark_set.add(position, gravity), position, gravity });
+            break;
+        }
+        case 1:
+            gap_buffer.insert(make_crange(word), position);
+            insert(marks, position, word.size());
+            break;
+        case 2:
+            gap_buffer.remove(position, remove_count);
+            remove(marks, position, remove_count);
+            break;
+        default:
+            gap_buffer.replace(position, remove_count, make_crange(word));
+            remove(marks, position, remove_count);
+            insert(marks, position, word.size());
+            break;
+        }
+        if ((count % 10) == 0) {
+            for (const auto& mark : marks) {
+                ASSERT_EQ(mark.position, mark_set.position(mark.mark));
+            }
+        }
+    }
+    gap_buffer.remove_observer(&mark_set);
+}
+}
+}
+}
+}
+
+TEST(mark_set, gravity) { cursor::test::mark_set::gravity(); }
+
+TEST(mark_set, add_and_remove) { cursor::test::mark_set::add_and_remove(); }
+
+TEST(mark_set, random_edits) { cursor::test::mark_set::random_edits(); }
@@ -0,0 +1,127 @@
+#include "gap-buffer.hh"
+#include "parallel-algorithm.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace parallel_algorithm {
+namespace {
+
+auto make_gap_buffer(const std::string& content, int gap_position)
+{
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(gap_position, 0);
+    return gap_buffer;
+}
+
+auto find_all_serial(const std::string& content, const std::string& needle)
+{
+    std::vector<std::ptrdiff_t> positions;
+    for (auto position = content.find(needle); position != std::string::npos; position = content.find(needle, position + 1)) {
+        positions.push_back(position);
+    }
+    return positions;
+}
+
+void thread_pool()
+{
+    parallel::ThreadPool pool{4};
+    ASSERT_EQ(4, pool.thread_count());
+    for (auto job = 0; job < 20; ++job) {
+        std::vector<std::atomic<int>> runs(100 + job);
+        pool.run(runs.size(), [&runs](std::ptrdiff_t index) { runs[index] += 1; });
+        for (const auto& run : runs) {
+            ASSERT_EQ(1, run);
+        }
+    }
+    ASSERT_THROW(pool.run(10, [](std::ptrdiff_t index) {
+        if (index == 5) {
+            throw std::runtime_error("Task failed");
+        }
+    }), std::runtime_error);
+    pool.run(0, [](std::ptrdiff_t) { FAIL(); });
+
+    parallel::ThreadPool single_thread_pool{1};
+    auto sum = 0;
+    single_thread_pool.run(10, [&sum](std::ptrdiff_t index) { sum += index; });
+    ASSERT_EQ(45, sum);
+}
+
+void count_and_reduce()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> letter_distribution{ 0, 2 };
+    std::string content(1000, ' ');
+    for (auto& letter : content) {
+        letter = "ab\n"[letter_distribution(random_engine)];
+    }
+    const auto newline_count = std::count(content.begin(), content.end(), '\n');
+    const auto letter_sum = std::accumulate(content.begin(), content.end(), 0L);
+    parallel::ThreadPool pool{4};
+    for (auto gap_position : { 0, 1, 499, 1000 }) {
+        const auto gap_buffer = make_gap_buffer(content, gap_position);
+        for (auto chunk_bytes : { 1, 7, 64, 4096 }) {
+            ASSERT_EQ(newline_count, parallel::count(pool, gap_buffer, '\n', chunk_bytes));
+            const auto sum = parallel::transform_reduce(pool, gap_buffer, 0L, std::plus<long>{},
+                [](char letter) { return static_cast<long>(letter); }, chunk_bytes);
+            ASSERT_EQ(letter_sum, sum);
+        }
+    }
+
+    GapBuffer<int> numbers;
+    const std::vector<int> values = { 3, 1, 4, 1, 5, 9, 2, 6 };
+    numbers.append(make_crange(values));
+    numbers.remove(3, 0);
+    ASSERT_EQ(2, parallel::count(pool, numbers, 1, 8));
+    const auto concatenated = parallel::transform_reduce(pool, numbers, std::string{ ">" }, std::plus<std::string>{},
+        [](int value) { return std::to_string(value); }, 8);
+    ASSERT_EQ(">31415926", concatenated);
+}
+
+void find_all()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> letter_distribution{ 0, 1 };
+    std::string content(500, ' ');
+    for (auto& letter : content) {
+        letter = "ab"[letter_distribution(random_engine)];
+    }
+    parallel::ThreadPool pool{4};
+    for (const std::string needle : { "a", "ab", "aab", "abba", "bbbbbb" }) {
+        const auto expected = find_all_serial(content, needle);
+        // Chunks smaller than the needle and gaps inside occurrences find
+        // the occurrences that span chunks and the gap.
+        for (auto gap_position : { 0, 3, 250, 251, 499, 500 }) {
+            const auto gap_buffer = make_gap_buffer(content, gap_position);
+            for (auto chunk_bytes : { 1, 2, 5, 64, 1 << 20 }) {
+                ASSERT_EQ(expected, parallel::find_all(pool, gap_buffer, needle.data(), needle.data() + needle.size(),
+                    chunk_bytes));
+            }
+        }
+    }
+    const auto gap_buffer = make_gap_buffer(content, 10);
+    ASSERT_TRUE(parallel::find_all(pool, gap_buffer, content.data(), content.data()).empty());
+    const auto whole = parallel::find_all(pool, gap_buffer, content.data(), content.data() + content.size(), 16);
+    ASSERT_EQ(std::vector<std::ptrdiff_t>{ 0 }, whole);
+}
+}
+}
+}
+}
+
+TEST(parallel_algorithm, thread_pool) { cursor::test::parallel_algorithm::thread_pool(); }
+
+TEST(parallel_algorithm, count_and_reduce) { cursor::test::parallel_algorithm::count_and_reduce(); }
+
+TEST(parallel_algorithm, find_all) { cursor::test::parallel_algorithm::find_all(); }
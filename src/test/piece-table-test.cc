@@ -0,0 +1,200 @@
+#include "piece-table.hh"
+#include "range.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace piece_table {
+namespace {
+
+std::string to_string(const PieceTable<char>& piece_table)
+{
+    return std::string(piece_table.cbegin(), piece_table.cend());
+}
+
+// Has no default constructor, so that copies must be constructed in place.
+struct Letter {
+    Letter(char value_)
+        : value{ value_ }
+    {
+    }
+    char value;
+};
+
+template <typename Element> struct CountingAllocator {
+    using value_type = Element;
+
+    CountingAllocator() = default;
+    template <typename OtherElement> CountingAllocator(const CountingAllocator<OtherElement>&) {}
+
+    Element* allocate(std::size_t count)
+    {
+        allocated_count += count;
+        return std::allocator<Element>{}.allocate(count);
+    }
+    void deallocate(Element* elements, std::size_t count)
+    {
+        allocated_count -= count;
+        std::allocator<Element>{}.deallocate(elements, count);
+    }
+    bool operator==(const CountingAllocator&) const { return true; }
+    bool operator!=(const CountingAllocator&) const { return false; }
+
+    static std::ptrdiff_t allocated_count;
+};
+
+template <typename Element> std::ptrdiff_t CountingAllocator<Element>::allocated_count = 0;
+
+void insert_and_remove()
+{
+    PieceTable<char> piece_table;
+    const std::string content = "The quick brown fox jumps over the lazy dog";
+    piece_table.assign(make_crange(content));
+    ASSERT_EQ(content, to_string(piece_table));
+    ASSERT_EQ(1, piece_table.piece_count());
+    const std::string word = "very ";
+    piece_table.insert(make_crange(word), 4);
+    ASSERT_EQ("The very quick brown fox jumps over the lazy dog", to_string(piece_table));
+    ASSERT_EQ(3, piece_table.piece_count());
+    piece_table.remove(4, 5);
+    ASSERT_EQ(content, to_string(piece_table));
+    ASSERT_EQ(1, piece_table.piece_count());
+    piece_table.replace(16, 3, make_crange(std::string("cat")));
+    ASSERT_EQ("The quick brown cat jumps over the lazy dog", to_string(piece_table));
+    ASSERT_THROW(piece_table.insert(make_crange(word), 44), std::out_of_range);
+    ASSERT_THROW(piece_table.remove(40, 4), std::out_of_range);
+    piece_table.remove(0, piece_table.size());
+    ASSERT_EQ(0, piece_table.size());
+    ASSERT_EQ(0, piece_table.piece_count());
+}
+
+void typing_extends_piece()
+{
+    PieceTable<char> piece_table;
+    piece_table.assign(make_crange(std::string("Hello World")));
+    const std::string typed = ", wide";
+    for (auto offset = 0; offset < static_cast<int>(typed.size()); ++offset) {
+        piece_table.insert(make_crange(typed.substr(offset, 1)), 5 + offset);
+    }
+    ASSERT_EQ("Hello, wide World", to_string(piece_table));
+    ASSERT_EQ(3, piece_table.piece_count());
+}
+
+void iterators()
+{
+    PieceTable<char> piece_table;
+    std::string content;
+    for (auto count = 0; count < 100; ++count) {
+        content.push_back('a' + (count % 26));
+    }
+    piece_table.assign(make_crange(content));
+    for (auto position : { 90, 50, 10 }) {
+        piece_table.insert(make_crange(std::string("-")), position);
+        content.insert(position, "-");
+    }
+    const auto begin = piece_table.begin();
+    const auto end = piece_table.end();
+    ASSERT_EQ(103, end - begin);
+    ASSERT_EQ(content[57], begin[57]);
+    ASSERT_EQ(content[102], *(end - 1));
+    ASSERT_EQ(begin + 10, (end - 93));
+    auto element = begin + 95;
+    element -= 80;
+    ASSERT_EQ(content[15], *element);
+    ASSERT_EQ(15, element - begin);
+    using ReverseIterator = std::reverse_iterator<PieceTable<char>::const_iterator>;
+    const std::string reversed{ ReverseIterator{ end }, ReverseIterator{ begin } };
+    ASSERT_TRUE(std::equal(reversed.rbegin(), reversed.rend(), content.begin()));
+    std::string segments;
+    piece_table.for_each_segment([&segments](const char* first, const char* last) { segments.append(first, last); });
+    ASSERT_EQ(content, segments);
+}
+
+void shared_original()
+{
+    PieceTable<char> piece_table;
+    const std::string content = "Hello World";
+    piece_table.assign(make_crange(content));
+    PieceTable<char> view{ piece_table.get_original(), piece_table.get_original_size() };
+    piece_table.remove(0, 6);
+    view.insert(make_crange(std::string("!")), 11);
+    ASSERT_EQ("World", to_string(piece_table));
+    ASSERT_EQ("Hello World!", to_string(view));
+    ASSERT_EQ(piece_table.get_original(), view.get_original());
+}
+
+void allocator()
+{
+    {
+        PieceTable<Letter, CountingAllocator<Letter> > piece_table;
+        const std::vector<Letter> letters = { 'a', 'b', 'c' };
+        piece_table.assign(make_crange(letters));
+        ASSERT_EQ(3, CountingAllocator<Letter>::allocated_count);
+        ASSERT_EQ('b', std::next(piece_table.cbegin())->value);
+        const auto original = piece_table.get_original();
+        piece_table.assign(make_crange(std::vector<Letter>{ 'd' }));
+        ASSERT_EQ(4, CountingAllocator<Letter>::allocated_count);
+        ASSERT_EQ('c', original.get()[2].value);
+    }
+    ASSERT_EQ(0, CountingAllocator<Letter>::allocated_count);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> word_size_distribution{ 0, 12 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    std::string expected(1000, 'a');
+    PieceTable<char> piece_table;
+    piece_table.assign(make_crange(expected));
+    for (auto count = 0; count < 5000; ++count) {
+        const auto content_size = static_cast<int>(expected.size());
+        const std::string word(word_size_distribution(random_engine), 'b' + (count % 25));
+        std::uniform_int_distribution<> position_distribution{ 0, content_size };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(16, content_size - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0:
+            piece_table.insert(make_crange(word), position);
+            expected.insert(position, word);
+            break;
+        case 1:
+            piece_table.remove(position, remove_count);
+            expected.erase(position, remove_count);
+            break;
+        default:
+            piece_table.replace(position, remove_count, make_crange(word));
+            expected.replace(position, remove_count, word);
+            break;
+        }
+        ASSERT_EQ(static_cast<std::ptrdiff_t>(expected.size()), piece_table.size());
+        if ((count % 10) == 0) {
+            ASSERT_EQ(expected, to_string(piece_table));
+        }
+    }
+}
+}
+}
+}
+}
+
+TEST(piece_table, insert_and_remove) { cursor::test::piece_table::insert_and_remove(); }
+
+TEST(piece_table, typing_extends_piece) { cursor::test::piece_table::typing_extends_piece(); }
+
+TEST(piece_table, iterators) { cursor::test::piece_table::iterators(); }
+
+TEST(piece_table, shared_original) { cursor::test::piece_table::shared_original(); }
+
+TEST(piece_table, allocator) { cursor::test::piece_table::allocator(); }
+
+TEST(piece_table, random_edits) { cursor::test::piece_table::random_edits(); }
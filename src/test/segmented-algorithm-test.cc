@@ -0,0 +1,129 @@
+#include "gap-buffer.hh"
+#include "range.hh"
+#include "segmented-algorithm.hh"
+
+#include <gtest/gtest.h>
+
+#include <iterator>
+#include <string>
+
+namespace cursor {
+namespace test {
+namespace segmented_algorithm {
+namespace {
+
+auto make_gap_buffer(const std::string& content, int gap_position)
+{
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(gap_position, 0);
+    return gap_buffer;
+}
+
+auto make_string_segments(const std::string& content)
+{
+    return segmented::make_segments(content.data(), content.data() + content.size());
+}
+
+void segments()
+{
+    const std::string content = "Hello World!";
+    const auto gap_buffer = make_gap_buffer(content, 5);
+    const auto segments = gap_buffer.segments();
+    ASSERT_EQ("Hello", std::string(segments.before_gap.begin(), segments.before_gap.end()));
+    ASSERT_EQ(" World!", std::string(segments.after_gap.begin(), segments.after_gap.end()));
+}
+
+void copy()
+{
+    const std::string content = "Hello World!";
+    for (auto gap_position = 0; gap_position <= static_cast<int>(content.size()); ++gap_position) {
+        const auto gap_buffer = make_gap_buffer(content, gap_position);
+        std::string copied_content;
+        segmented::copy(gap_buffer, std::back_inserter(copied_content));
+        ASSERT_EQ(content, copied_content);
+        std::string copied_subsegments;
+        segmented::copy(segmented::subsegments(gap_buffer, 3, 5), std::back_inserter(copied_subsegments));
+        ASSERT_EQ(content.substr(3, 5), copied_subsegments);
+    }
+}
+
+void find()
+{
+    const std::string content = "Hello World!";
+    for (auto gap_position = 0; gap_position <= static_cast<int>(content.size()); ++gap_position) {
+        const auto gap_buffer = make_gap_buffer(content, gap_position);
+        ASSERT_EQ(0, segmented::find(gap_buffer, 'H'));
+        ASSERT_EQ(4, segmented::find(gap_buffer, 'o'));
+        ASSERT_EQ(11, segmented::find(gap_buffer, '!'));
+        ASSERT_EQ(gap_buffer.size(), segmented::find(gap_buffer, 'x'));
+    }
+}
+
+void count()
+{
+    const std::string content = "Hello World!";
+    for (auto gap_position = 0; gap_position <= static_cast<int>(content.size()); ++gap_position) {
+        const auto gap_buffer = make_gap_buffer(content, gap_position);
+        ASSERT_EQ(3, segmented::count(gap_buffer, 'l'));
+        ASSERT_EQ(0, segmented::count(gap_buffer, 'x'));
+    }
+}
+
+void equal()
+{
+    const std::string content = "Hello World!";
+    for (auto lhs_gap_position = 0; lhs_gap_position <= static_cast<int>(content.size()); ++lhs_gap_position) {
+        const auto lhs = make_gap_buffer(content, lhs_gap_position);
+        ASSERT_TRUE(segmented::equal(lhs, make_string_segments(content)));
+        ASSERT_FALSE(segmented::equal(lhs, make_string_segments("Hello World?")));
+        ASSERT_FALSE(segmented::equal(lhs, make_string_segments("Hello")));
+        for (auto rhs_gap_position = 0; rhs_gap_position <= static_cast<int>(content.size()); ++rhs_gap_position) {
+            const auto rhs = make_gap_buffer(content, rhs_gap_position);
+            ASSERT_TRUE(segmented::equal(lhs, rhs));
+        }
+    }
+}
+
+void for_each()
+{
+    const std::string content = "Hello World!";
+    const auto gap_buffer = make_gap_buffer(content, 3);
+    std::string visited_content;
+    segmented::for_each(gap_buffer, [&visited_content](char element) { visited_content.push_back(element); });
+    ASSERT_EQ(content, visited_content);
+}
+
+void for_each_segment_in_range()
+{
+    const std::string content = "Hello World!";
+    for (auto gap_position = 0; gap_position <= static_cast<int>(content.size()); ++gap_position) {
+        const auto gap_buffer = make_gap_buffer(content, gap_position);
+        std::string visited_content;
+        segmented::for_each_segment(gap_buffer, 2, 7, [&visited_content](const char* first, const char* last) {
+            visited_content.append(first, last);
+        });
+        ASSERT_EQ(content.substr(2, 7), visited_content);
+    }
+}
+}
+}
+}
+}
+
+TEST(segmented_algorithm, segments) { cursor::test::segmented_algorithm::segments(); }
+
+TEST(segmented_algorithm, copy) { cursor::test::segmented_algorithm::copy(); }
+
+TEST(segmented_algorithm, find) { cursor::test::segmented_algorithm::find(); }
+
+TEST(segmented_algorithm, count) { cursor::test::segmented_algorithm::count(); }
+
+TEST(segmented_algorithm, equal) { cursor::test::segmented_algorithm::equal(); }
+
+TEST(segmented_algorithm, for_each) { cursor::test::segmented_algorithm::for_each(); }
+
+TEST(segmented_algorithm, for_each_segment_in_range)
+{
+    cursor::test::segmented_algorithm::for_each_segment_in_range();
+}
@@ -0,0 +1,125 @@
+#include "gap-buffer.hh"
+#include "range.hh"
+#include "trigram-index.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace trigram_index {
+namespace {
+
+auto find_all_serial(const std::string& content, const std::string& needle)
+{
+    std::vector<std::ptrdiff_t> positions;
+    for (auto position = content.find(needle); position != std::string::npos; position = content.find(needle, position + 1)) {
+        positions.push_back(position);
+    }
+    return positions;
+}
+
+template <typename RandomEngine> auto make_random_text(RandomEngine& random_engine, int size)
+{
+    const std::vector<std::string> words = { "gap", "buffer", "cursor", "line", "index", "\n", " " };
+    std::uniform_int_distribution<> word_distribution{ 0, static_cast<int>(words.size()) - 1 };
+    std::string text;
+    while (static_cast<int>(text.size()) < size) {
+        text += words[word_distribution(random_engine)];
+    }
+    return text;
+}
+
+void search()
+{
+    std::mt19937 random_engine;
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(make_random_text(random_engine, 300000)));
+    gap_buffer.insert(make_crange(std::string{ "needle" }), 100000);
+    TrigramIndex trigram_index;
+    gap_buffer.add_observer(&trigram_index);
+    const std::string content(gap_buffer.cbegin(), gap_buffer.cend());
+
+    const std::string needle = "needle";
+    ASSERT_EQ(trigram_index.block_count(), trigram_index.stale_block_count());
+    ASSERT_EQ(100000, trigram_index.search(gap_buffer, 0, needle.data(), needle.data() + needle.size()));
+    ASSERT_EQ(0, trigram_index.stale_block_count());
+    ASSERT_EQ(gap_buffer.size(), trigram_index.search(gap_buffer, 100001, needle.data(), needle.data() + needle.size()));
+    for (const std::string other_needle : { "ga", "gap buffer", "index\nline", "r c", "cursors" }) {
+        ASSERT_EQ(find_all_serial(content, other_needle),
+            trigram_index.find_all(gap_buffer, other_needle.data(), other_needle.data() + other_needle.size()));
+    }
+    // Occurrences that start in one block and end in the next are found,
+    // also when they are longer than the overlap of the filters.
+    const auto block_end = 4 * (TrigramIndex::max_block_size / 2);
+    for (auto needle_size : { 20, 1000 }) {
+        const auto spanning = content.substr(block_end - 10, needle_size);
+        ASSERT_EQ(block_end - 10, trigram_index.search(gap_buffer, 100001, spanning.data(), spanning.data() + spanning.size()));
+    }
+
+    // Typing only makes the filters around the edit stale.
+    gap_buffer.insert(make_crange(std::string{ "x" }), 200000);
+    ASSERT_LE(trigram_index.stale_block_count(), 2);
+    const std::string typed = "needle";
+    gap_buffer.insert(make_crange(typed), 150000);
+    ASSERT_EQ(150000, trigram_index.search(gap_buffer, 100001, needle.data(), needle.data() + needle.size()));
+    gap_buffer.remove_observer(&trigram_index);
+}
+
+void random_edits()
+{
+    std::mt19937 random_engine;
+    std::uniform_int_distribution<> size_distribution{ 0, 3000 };
+    std::uniform_int_distribution<> operation_distribution{ 0, 2 };
+    // The content spans several blocks, so that occurrences also span
+    // blocks.
+    std::string expected = make_random_text(random_engine, 200000);
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(expected));
+    TrigramIndex trigram_index;
+    gap_buffer.add_observer(&trigram_index);
+    const std::vector<std::string> needles = { "gap", "r\nb", "line index", "x" };
+    for (auto count = 0; count < 500; ++count) {
+        const auto word = make_random_text(random_engine, size_distribution(random_engine));
+        const auto content_size = static_cast<int>(expected.size());
+        std::uniform_int_distribution<> position_distribution{ 0, content_size };
+        const auto position = position_distribution(random_engine);
+        std::uniform_int_distribution<> count_distribution{ 0, std::min(3000, content_size - position) };
+        const auto remove_count = count_distribution(random_engine);
+        switch (operation_distribution(random_engine)) {
+        case 0:
+            gap_buffer.insert(make_crange(word), position);
+            expected.insert(position, word);
+            break;
+        case 1:
+            gap_buffer.remove(position, remove_count);
+            expected.erase(position, remove_count);
+            break;
+        default:
+            gap_buffer.replace(position, remove_count, make_crange(word));
+            expected.replace(position, remove_count, word);
+            break;
+        }
+        if ((count % 10) == 0) {
+            for (const auto& needle : needles) {
+                ASSERT_EQ(find_all_serial(expected, needle),
+                    trigram_index.find_all(gap_buffer, needle.data(), needle.data() + needle.size()));
+            }
+            const auto block_size = TrigramIndex::max_block_size / 4;
+            ASSERT_LE(trigram_index.block_count(), 2 + (2 * static_cast<int>(expected.size())) / block_size);
+        }
+    }
+    gap_buffer.remove_observer(&trigram_index);
+}
+}
+}
+}
+}
+
+TEST(trigram_index, search) { cursor::test::trigram_index::search(); }
+
+TEST(trigram_index, random_edits) { cursor::test::trigram_index::random_edits(); }
@@ -0,0 +1,134 @@
+#include "gap-buffer.hh"
+#include "range.hh"
+#include "utf8.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cursor {
+namespace test {
+namespace utf8 {
+namespace {
+
+using cursor::utf8::Isa;
+
+auto supported_isas()
+{
+    std::vector<Isa> isas;
+    for (auto isa : { Isa::scalar, Isa::sse2, Isa::avx2 }) {
+        if (cursor::byte_search::is_supported(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    return isas;
+}
+
+// Code points of one to four bytes, and a newline.
+const std::vector<std::string> characters = { "a", "\n", "\xc3\xa9", "\xe4\xb8\xad", "\xf0\x9f\x98\x80" };
+
+template <typename RandomEngine> auto make_random_text(RandomEngine& random_engine, int code_point_count)
+{
+    std::uniform_int_distribution<> character_distribution{ 0, static_cast<int>(characters.size()) - 1 };
+    std::string text;
+    for (auto code_point = 0; code_point < code_point_count; ++code_point) {
+        text += characters[character_distribution(random_engine)];
+    }
+    return text;
+}
+
+auto make_gap_buffer(const std::string& content, int gap_position)
+{
+    GapBuffer<char> gap_buffer;
+    gap_buffer.append(make_crange(content));
+    gap_buffer.remove(gap_position, 0);
+    return gap_buffer;
+}
+
+void count_and_validate()
+{
+    std::mt19937 random_engine;
+    for (auto isa : supported_isas()) {
+        for (auto code_point_count = 0; code_point_count < 100; ++code_point_count) {
+            auto text = make_random_text(random_engine, code_point_count);
+            const auto first = text.data();
+            const auto last = text.data() + text.size();
+            ASSERT_EQ(code_point_count, cursor::utf8::count(first, last, isa));
+            ASSERT_TRUE(cursor::utf8::is_valid(first, last, isa));
+            if (text.empty()) {
+                continue;
+            }
+            std::uniform_int_distribution<> index_distribution{ 0, code_point_count };
+            const auto index = index_distribution(random_engine);
+            const auto found = cursor::utf8::find_code_point(first, last, index, isa);
+            ASSERT_EQ(index, cursor::utf8::count(first, found, isa));
+            ASSERT_TRUE((found == last) || cursor::utf8::detail::is_lead(*found));
+
+            const auto last_code_point = cursor::utf8::find_code_point(first, last, code_point_count - 1, isa);
+            const auto expected_invalid = ((last - last_code_point) == 1) ? (last - 1) : last_code_point;
+            ASSERT_EQ(expected_invalid, cursor::utf8::find_invalid(first, last - 1, isa));
+
+            const auto invalid = cursor::utf8::find_code_point(first, last, index % code_point_count, isa);
+            text[invalid - first] = '\xff';
+            ASSERT_EQ(invalid, cursor::utf8::find_invalid(first, last, isa));
+        }
+    }
+    for (const auto& invalid : { "\xc0\xaf", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf8\x88\x80\x80", "\x80" }) {
+        const std::string text = std::string(40, 'a') + invalid + std::string(40, 'a');
+        for (auto isa : supported_isas()) {
+            ASSERT_EQ(text.data() + 40, cursor::utf8::find_invalid(text.data(), text.data() + text.size(), isa));
+        }
+    }
+}
+
+void segmented()
+{
+    std::mt19937 random_engine;
+    const auto text = make_random_text(random_engine, 200);
+    const auto code_point_count = cursor::utf8::count(text.data(), text.data() + text.size());
+    for (auto isa : supported_isas()) {
+        for (auto gap_position = 0; gap_position <= static_cast<int>(text.size()); ++gap_position) {
+            const auto gap_buffer = make_gap_buffer(text, gap_position);
+            ASSERT_EQ(code_point_count, cursor::utf8::count(gap_buffer, 0, gap_buffer.size(), isa));
+            ASSERT_TRUE(cursor::utf8::is_valid(gap_buffer, isa));
+            for (auto index = 0; index <= code_point_count; index += 7) {
+                const auto expected = cursor::utf8::find_code_point(text.data(), text.data() + text.size(), index) - text.data();
+                ASSERT_EQ(expected, cursor::utf8::find_code_point(gap_buffer, 0, index, isa));
+            }
+        }
+    }
+
+    auto invalid = text;
+    invalid.insert(100, "\xe4\xb8");
+    for (auto gap_position = 99; gap_position <= 103; ++gap_position) {
+        const auto gap_buffer = make_gap_buffer(invalid, gap_position);
+        const auto expected = cursor::utf8::find_invalid(invalid.data(), invalid.data() + invalid.size()) - invalid.data();
+        ASSERT_EQ(expected, cursor::utf8::find_invalid(gap_buffer));
+    }
+}
+
+void iterators()
+{
+    const std::string text = "a\xc3\xa9\xe4\xb8\xad\xf0\x9f\x98\x80\xe4\xb8";
+    const auto gap_buffer = make_gap_buffer(text, 4);
+    const auto code_points = cursor::utf8::make_code_point_range(make_crange(gap_buffer));
+    const std::u32string expected = { U'a', 0xe9, 0x4e2d, 0x1f600, cursor::utf8::replacement_character };
+    ASSERT_EQ(expected, std::u32string(code_points.begin(), code_points.end()));
+    const std::u32string reversed{ std::make_reverse_iterator(code_points.end()), std::make_reverse_iterator(code_points.begin()) };
+    ASSERT_TRUE(std::equal(reversed.rbegin(), reversed.rend(), expected.begin()));
+    ASSERT_EQ(3, std::next(code_points.begin(), 2).base() - gap_buffer.cbegin());
+}
+}
+}
+}
+}
+
+TEST(utf8, count_and_validate) { cursor::test::utf8::count_and_validate(); }
+
+TEST(utf8, segmented) { cursor::test::utf8::segmented(); }
+
+TEST(utf8, iterators) { cursor::test::utf8::iterators(); }
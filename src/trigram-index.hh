@@ -0,0 +1,358 @@
+#pragma once
+
+#include "block-index.hh"
+#include "byte-search.hh"
+#include "gap-buffer.hh"
+#include "segmented-algorithm.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cursor {
+// The blocks of a TrigramIndex only need their lengths, so their summary is
+// empty.
+struct NoSummary {
+    static NoSummary combine(const NoSummary&, const NoSummary&) {
+        return {};
+    }
+};
+
+// Keeps a filter of the trigrams of each block of a GapBuffer<char> it
+// observes, so that searching the buffer again and again only reads the
+// blocks that may hold the needle. A block whose filter lacks one of the
+// trigrams of the needle cannot hold an occurrence that starts in it, and is
+// skipped, while the others are searched with byte_search.
+//
+// The content is divided into blocks of at most max_block_size bytes, kept
+// in a BlockIndex. The filter of a block has a bit for each of
+// filter_bit_count buckets of trigrams, set for the trigrams that start in
+// the block or in the filter_overlap bytes after it, so that an occurrence
+// that starts in a block has the first filter_overlap + 1 of its trigrams in
+// the filter of the block wherever it ends. Edits only mark the filters of
+// the blocks they touch as stale, and stale filters are rebuilt by the next
+// search, so typing costs O(log n) and a search rebuilds at most the blocks
+// edited since the last one. The filters are kept in one array indexed by
+// block, and take roughly an eighth to a quarter of the size of the content.
+class TrigramIndex : public GapBufferObserver<char> {
+public:
+    using size_type = std::ptrdiff_t;
+
+    static constexpr size_type max_block_size = 64 << 10;
+    static constexpr int filter_bit_count = 1 << 16;
+    static constexpr size_type filter_overlap = 256;
+
+private:
+    using block_type = BlockIndex<NoSummary>::block_type;
+
+    static constexpr block_type no_block = BlockIndex<NoSummary>::no_block;
+
+public:
+    void reset(const Segments<const char>& content) override {
+        blocks.clear();
+        filter_words.clear();
+        is_stale.clear();
+        stale_blocks.clear();
+        bucket_block_counts.assign(filter_bit_count, 0);
+        insert_blocks(no_block, 0, segmented::size(content));
+    }
+
+    void inserted(const Segments<const char>&, size_type position, size_type count) override {
+        if (count == 0) {
+            return;
+        }
+        const auto located = blocks.locate(position);
+        auto block = located.first;
+        if (block == no_block) {
+            insert_blocks(no_block, position, count);
+            return;
+        }
+        if ((located.second == 0) && (blocks.previous(block) != no_block)) {
+            block = blocks.previous(block);
+        }
+        invalidate_before(block);
+
+        const auto length = blocks.length(block) + count;
+        if (length <= max_block_size) {
+            blocks.update(block, length, {});
+            invalidate(block);
+            return;
+        }
+        insert_blocks(block, blocks.block_position(block), length);
+        erase_block(block);
+    }
+
+    void removing(const Segments<const char>&, size_type position, size_type count) override {
+        if (count == 0) {
+            return;
+        }
+        auto located = blocks.locate(position);
+        auto block = located.first;
+        auto offset = located.second;
+        invalidate_before(block);
+        for (auto removed_position = position; removed_position < (position + count);) {
+            const auto removed_count = std::min(position + count - removed_position, blocks.length(block) - offset);
+            const auto next = blocks.next(block);
+            const auto length = blocks.length(block) - removed_count;
+            if (length == 0) {
+                erase_block(block);
+            } else {
+                blocks.update(block, length, {});
+                invalidate(block);
+            }
+            removed_position += removed_count;
+            block = next;
+            offset = 0;
+        }
+
+        if (blocks.block_count() == 0) {
+            return;
+        }
+        block = (position < blocks.size()) ? blocks.locate(position).first : blocks.last_block();
+        block = merge_if_small(block, blocks.previous(block));
+        merge_if_small(block, blocks.next(block));
+    }
+
+    // Returns the position of the first occurrence of the needle that starts
+    // at or after position, or the size of the content, like
+    // byte_search::search. The buffer must be the one the index observes.
+    // Needles shorter than a trigram are searched without the index.
+    template<typename GapBufferType>
+    size_type search(const GapBufferType& gap_buffer, size_type position, const char* needle_first,
+        const char* needle_last) {
+        const auto content = gap_buffer.csegments();
+        const auto content_size = blocks.size();
+        const auto needle_size = needle_last - needle_first;
+        if ((needle_size < 3) || ((content_size - position) < needle_size)) {
+            return byte_search::search(content, position, needle_first, needle_last);
+        }
+
+        for (const auto& candidate : candidate_blocks(content, needle_first, needle_last)) {
+            const auto block_end = candidate.first + blocks.length(candidate.second);
+            if (block_end <= position) {
+                continue;
+            }
+            const auto first = std::max(position, candidate.first);
+            const auto found = first + search_block(content, first, block_end, needle_first, needle_last);
+            if (found < block_end) {
+                return found;
+            }
+        }
+        return content_size;
+    }
+
+    // Returns the positions of every occurrence of the needle in order,
+    // including occurrences that overlap.
+    template<typename GapBufferType>
+    std::vector<size_type> find_all(const GapBufferType& gap_buffer, const char* needle_first, const char* needle_last) {
+        const auto content = gap_buffer.csegments();
+        const auto content_size = blocks.size();
+        const auto needle_size = needle_last - needle_first;
+        std::vector<size_type> positions;
+        if (needle_size == 0) {
+            return positions;
+        }
+        if (needle_size < 3) {
+            for (auto found = byte_search::search(content, 0, needle_first, needle_last); found != content_size;
+                 found = byte_search::search(content, found + 1, needle_first, needle_last)) {
+                positions.push_back(found);
+            }
+            return positions;
+        }
+
+        for (const auto& candidate : candidate_blocks(content, needle_first, needle_last)) {
+            const auto block_end = candidate.first + blocks.length(candidate.second);
+            for (auto found = candidate.first + search_block(content, candidate.first, block_end, needle_first, needle_last);
+                 found < block_end;
+                 found += 1 + search_block(content, found + 1, block_end, needle_first, needle_last)) {
+                positions.push_back(found);
+            }
+        }
+        return positions;
+    }
+
+    size_type block_count() const {
+        return blocks.block_count();
+    }
+
+    // Returns the number of blocks whose filters the next search rebuilds.
+    size_type stale_block_count() const {
+        return std::count(is_stale.begin(), is_stale.end(), 1);
+    }
+
+private:
+    static constexpr int filter_word_count = filter_bit_count / 64;
+
+    static std::uint32_t make_trigram(char first, char second, char third) {
+        return (static_cast<std::uint32_t>(static_cast<unsigned char>(first)) << 16)
+            | (static_cast<std::uint32_t>(static_cast<unsigned char>(second)) << 8)
+            | static_cast<std::uint32_t>(static_cast<unsigned char>(third));
+    }
+
+    // Spreads the trigrams over the buckets with a multiplicative hash, as
+    // text uses few of the possible trigrams.
+    static int bucket_of(std::uint32_t trigram) {
+        return static_cast<int>((trigram * std::uint32_t{2654435761u}) >> 16);
+    }
+
+    std::uint64_t* filter_of(block_type block) {
+        return filter_words.data() + (block * filter_word_count);
+    }
+
+    // Returns the blocks whose filters have the buckets of every trigram of
+    // the needle, with their positions, in order. The filters are scanned in
+    // the order of the pool, testing first the bucket set in the fewest
+    // blocks, so that most blocks are ruled out by reading one word each at
+    // a constant stride.
+    std::vector<std::pair<size_type, block_type>> candidate_blocks(const Segments<const char>& content,
+        const char* needle_first, const char* needle_last) {
+        refresh(content);
+        std::vector<int> buckets;
+        const auto trigram_count = std::min<size_type>(needle_last - needle_first - 2, filter_overlap + 1);
+        for (auto trigram = needle_first; trigram != (needle_first + trigram_count); ++trigram) {
+            buckets.push_back(bucket_of(make_trigram(trigram[0], trigram[1], trigram[2])));
+        }
+        std::sort(buckets.begin(), buckets.end(), [this](int lhs, int rhs) {
+            return (bucket_block_counts[lhs] != bucket_block_counts[rhs])
+                ? (bucket_block_counts[lhs] < bucket_block_counts[rhs]) : (lhs < rhs);
+        });
+        buckets.erase(std::unique(buckets.begin(), buckets.end()), buckets.end());
+
+        std::vector<std::pair<size_type, block_type>> candidates;
+        const auto block_capacity = static_cast<block_type>(is_stale.size());
+        for (block_type block = 0; block < block_capacity; ++block) {
+            const auto filter = filter_of(block);
+            const auto is_candidate = std::all_of(buckets.begin(), buckets.end(), [filter](int bucket) {
+                return ((filter[bucket / 64] >> (bucket % 64)) & 1) != 0;
+            });
+            if (is_candidate) {
+                candidates.emplace_back(blocks.block_position(block), block);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        return candidates;
+    }
+
+    // Returns the offset from first of the first occurrence of the needle
+    // that starts in [first, last), or of last - first if there is none.
+    size_type search_block(const Segments<const char>& content, size_type first, size_type last,
+        const char* needle_first, const char* needle_last) {
+        const auto searched_count = std::min(last + (needle_last - needle_first) - 1, blocks.size()) - first;
+        return std::min(byte_search::search(segmented::subsegments(content, first, searched_count), 0, needle_first,
+            needle_last), last - first);
+    }
+
+    void invalidate(block_type block) {
+        if ((block != no_block) && !is_stale[block]) {
+            is_stale[block] = 1;
+            stale_blocks.push_back(block);
+        }
+    }
+
+    // Marks stale the blocks before block whose filters cover some of it.
+    void invalidate_before(block_type block) {
+        size_type distance = 0;
+        for (auto previous = blocks.previous(block); (previous != no_block) && (distance < filter_overlap);
+             previous = blocks.previous(previous)) {
+            invalidate(previous);
+            distance += blocks.length(previous);
+        }
+    }
+
+    void erase_block(block_type block) {
+        clear_filter(block);
+        is_stale[block] = 0;
+        blocks.erase(block);
+    }
+
+    void clear_filter(block_type block) {
+        const auto filter = filter_of(block);
+        for (auto word = 0; word < filter_word_count; ++word) {
+            for (auto bits = filter[word]; bits != 0; bits &= bits - 1) {
+                bucket_block_counts[(word * 64) + __builtin_ctzll(bits)] -= 1;
+            }
+            filter[word] = 0;
+        }
+    }
+
+    // Rebuilds the filters of the blocks edited since the last search.
+    void refresh(const Segments<const char>& content) {
+        for (const auto block : stale_blocks) {
+            if (is_stale[block]) {
+                rebuild(content, block, blocks.block_position(block));
+            }
+        }
+        stale_blocks.clear();
+    }
+
+    // Sets the bits of the trigrams that start in block or in the
+    // filter_overlap bytes after it.
+    void rebuild(const Segments<const char>& content, block_type block, size_type block_position) {
+        clear_filter(block);
+        const auto filter = filter_of(block);
+        const auto last = std::min(block_position + blocks.length(block) + filter_overlap + 2, blocks.size());
+        std::uint32_t trigram = 0;
+        size_type byte_count = 0;
+        segmented::for_each_segment(content, block_position, last - block_position,
+            [filter, &trigram, &byte_count](const char* first, const char* last_) {
+                for (auto byte = first; byte != last_; ++byte) {
+                    trigram = ((trigram << 8) | static_cast<unsigned char>(*byte)) & 0xffffff;
+                    byte_count += 1;
+                    if (byte_count >= 3) {
+                        const auto bucket = bucket_of(trigram);
+                        filter[bucket / 64] |= std::uint64_t{1} << (bucket % 64);
+                    }
+                }
+            });
+        for (auto word = 0; word < filter_word_count; ++word) {
+            for (auto bits = filter[word]; bits != 0; bits &= bits - 1) {
+                bucket_block_counts[(word * 64) + __builtin_ctzll(bits)] += 1;
+            }
+        }
+        is_stale[block] = 0;
+    }
+
+    // Adds stale blocks of half the maximum size for the length bytes at
+    // position after previous.
+    void insert_blocks(block_type previous, size_type position, size_type length) {
+        const auto piece_size = max_block_size / 2;
+        for (auto piece_position = position; piece_position < (position + length); piece_position += piece_size) {
+            const auto piece_length = std::min(piece_size, position + length - piece_position);
+            previous = blocks.insert_after(previous, piece_length, {});
+            if (static_cast<block_type>(is_stale.size()) <= previous) {
+                is_stale.resize(previous + 1, 0);
+                filter_words.resize(is_stale.size() * filter_word_count, 0);
+            }
+            invalidate(previous);
+        }
+    }
+
+    // Joins block with neighbour, one of the blocks next to it, when block is
+    // under a quarter of the maximum size and both fit in one block. Returns
+    // the block that remains.
+    block_type merge_if_small(block_type block, block_type neighbour) {
+        if ((neighbour == no_block) || (blocks.length(block) >= (max_block_size / 4))
+            || ((blocks.length(block) + blocks.length(neighbour)) > max_block_size)) {
+            return block;
+        }
+        const auto first = (neighbour == blocks.previous(block)) ? neighbour : block;
+        const auto second = blocks.next(first);
+        blocks.update(first, blocks.length(first) + blocks.length(second), {});
+        invalidate(first);
+        erase_block(second);
+        return first;
+    }
+
+    BlockIndex<NoSummary> blocks;
+    // The filters of the blocks, filter_word_count words for each block in
+    // the pool. The filters of erased blocks are empty.
+    std::vector<std::uint64_t> filter_words;
+    std::vector<char> is_stale;
+    std::vector<block_type> stale_blocks;
+    // The number of blocks whose filters have each bucket.
+    std::vector<std::int32_t> bucket_block_counts = std::vector<std::int32_t>(filter_bit_count, 0);
+};
+
+}
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "byte-search.hh"
+#include "range.hh"
+#include "segmented-algorithm.hh"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+#ifdef CURSOR_BYTE_SEARCH_X86
+#include <immintrin.h>
+#endif
+
+namespace cursor {
+namespace utf8 {
+// The kernels are dispatched like the byte search kernels.
+using Isa = byte_search::Isa;
+
+constexpr char32_t replacement_character = 0xfffd;
+
+namespace detail {
+// Every byte but a continuation byte starts a code point, so counting code
+// points does not depend on where a run of bytes starts or ends.
+inline bool is_lead(char byte) {
+    return static_cast<signed char>(byte) > -65;
+}
+
+inline std::ptrdiff_t count_scalar(const char* first, const char* last) {
+    std::ptrdiff_t code_point_count = 0;
+    for (; first != last; ++first) {
+        code_point_count += is_lead(*first);
+    }
+    return code_point_count;
+}
+
+// Returns the length of the sequence at first if it is valid UTF-8, 0 if it
+// is invalid, or -1 if it is valid so far but runs past last.
+inline int sequence_length(const char* first, const char* last) {
+    const auto lead = static_cast<unsigned char>(*first);
+    if (lead < 0x80) {
+        return 1;
+    }
+    int length;
+    unsigned char second_min = 0x80;
+    unsigned char second_max = 0xbf;
+    if (lead < 0xc2) {
+        return 0;
+    } else if (lead < 0xe0) {
+        length = 2;
+    } else if (lead < 0xf0) {
+        length = 3;
+        second_min = (lead == 0xe0) ? 0xa0 : second_min;
+        second_max = (lead == 0xed) ? 0x9f : second_max;
+    } else if (lead < 0xf5) {
+        length = 4;
+        second_min = (lead == 0xf0) ? 0x90 : second_min;
+        second_max = (lead == 0xf4) ? 0x8f : second_max;
+    } else {
+        return 0;
+    }
+    for (auto index = 1; index < length; ++index) {
+        if ((first + index) == last) {
+            return -1;
+        }
+        const auto byte = static_cast<unsigned char>(first[index]);
+        if ((byte < ((index == 1) ? second_min : 0x80)) || (byte > ((index == 1) ? second_max : 0xbf))) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+inline const char* find_invalid_scalar(const char* first, const char* last) {
+    while (first != last) {
+        const auto length = sequence_length(first, last);
+        if (length <= 0) {
+            return first;
+        }
+        first += length;
+    }
+    return last;
+}
+
+#ifdef CURSOR_BYTE_SEARCH_X86
+__attribute__((target("sse2")))
+inline std::ptrdiff_t count_sse2(const char* first, const char* last) {
+    const auto continuation_max = _mm_set1_epi8(-65);
+    std::ptrdiff_t code_point_count = 0;
+    for (; (last - first) >= 16; first += 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpgt_epi8(block, continuation_max)));
+        code_point_count += __builtin_popcount(mask);
+    }
+    return code_point_count + count_scalar(first, last);
+}
+
+// Skips blocks of ASCII, which are valid whatever they hold, and decodes the
+// sequences of the other blocks one by one.
+__attribute__((target("sse2")))
+inline const char* find_invalid_sse2(const char* first, const char* last) {
+    while ((last - first) >= 16) {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(block));
+        const auto block_last = first + 16;
+        if (mask == 0) {
+            first = block_last;
+            continue;
+        }
+        first += byte_search::detail::count_trailing_zeros(mask);
+        while (first < block_last) {
+            const auto length = sequence_length(first, last);
+            if (length <= 0) {
+                return first;
+            }
+            first += length;
+        }
+    }
+    return find_invalid_scalar(first, last);
+}
+
+__attribute__((target("avx2")))
+inline std::ptrdiff_t count_avx2(const char* first, const char* last) {
+    const auto continuation_max = _mm256_set1_epi8(-65);
+    std::ptrdiff_t code_point_count = 0;
+    for (; (last - first) >= 32; first += 32) {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(block, continuation_max)));
+        code_point_count += __builtin_popcount(mask);
+    }
+    return code_point_count + count_sse2(first, last);
+}
+
+__attribute__((target("avx2")))
+inline const char* find_invalid_avx2(const char* first, const char* last) {
+    while ((last - first) >= 32) {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+        const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(block));
+        const auto block_last = first + 32;
+        if (mask == 0) {
+            first = block_last;
+            continue;
+        }
+        first += byte_search::detail::count_trailing_zeros(mask);
+        while (first < block_last) {
+            const auto length = sequence_length(first, last);
+            if (length <= 0) {
+                return first;
+            }
+            first += length;
+        }
+    }
+    return find_invalid_sse2(first, last);
+}
+#endif
+
+// Decodes the code point at element, which is a lead byte and the
+// continuation bytes after it. Sequences that are not valid UTF-8 decode to
+// the replacement character.
+template<typename ByteIterator>
+char32_t decode(ByteIterator element, ByteIterator last) {
+    const auto lead = static_cast<unsigned char>(*element);
+    if (lead < 0x80) {
+        return lead;
+    }
+    int length;
+    char32_t code_point;
+    char32_t code_point_min;
+    if (lead < 0xc2) {
+        return replacement_character;
+    } else if (lead < 0xe0) {
+        length = 2;
+        code_point = lead & 0x1f;
+        code_point_min = 0x80;
+    } else if (lead < 0xf0) {
+        length = 3;
+        code_point = lead & 0x0f;
+        code_point_min = 0x800;
+    } else if (lead < 0xf5) {
+        length = 4;
+        code_point = lead & 0x07;
+        code_point_min = 0x10000;
+    } else {
+        return replacement_character;
+    }
+    for (auto index = 1; index < length; ++index) {
+        ++element;
+        if ((element == last) || ((static_cast<unsigned char>(*element) & 0xc0) != 0x80)) {
+            return replacement_character;
+        }
+        code_point = (code_point << 6) | (static_cast<unsigned char>(*element) & 0x3f);
+    }
+    if ((code_point < code_point_min) || ((code_point >= 0xd800) && (code_point <= 0xdfff)) || (code_point > 0x10ffff)) {
+        return replacement_character;
+    }
+    return code_point;
+}
+}
+
+inline Isa supported_isa() {
+    return byte_search::supported_isa();
+}
+
+// Returns the number of code points that start in [first, last).
+inline std::ptrdiff_t count(const char* first, const char* last, Isa isa = supported_isa()) {
+    switch (isa) {
+#ifdef CURSOR_BYTE_SEARCH_X86
+    case Isa::avx2:
+        return detail::count_avx2(first, last);
+    case Isa::sse2:
+        return detail::count_sse2(first, last);
+#endif
+    default:
+        return detail::count_scalar(first, last);
+    }
+}
+
+// Returns a pointer to the first sequence in [first, last) that is not valid
+// UTF-8 or is cut short by last, or last.
+inline const char* find_invalid(const char* first, const char* last, Isa isa = supported_isa()) {
+    switch (isa) {
+#ifdef CURSOR_BYTE_SEARCH_X86
+    case Isa::avx2:
+        return detail::find_invalid_avx2(first, last);
+    case Isa::sse2:
+        return detail::find_invalid_sse2(first, last);
+#endif
+    default:
+        return detail::find_invalid_scalar(first, last);
+    }
+}
+
+inline bool is_valid(const char* first, const char* last, Isa isa = supported_isa()) {
+    return find_invalid(first, last, isa) == last;
+}
+
+// Returns a pointer to the start of the code point index code points after
+// the one that starts first, or last if [first, last) holds fewer. Code
+// points are counted a stride at a time until the stride that holds the one
+// wanted.
+inline const char* find_code_point(const char* first, const char* last, std::ptrdiff_t index, Isa isa = supported_isa()) {
+    constexpr std::ptrdiff_t stride = 64;
+    for (; (last - first) >= stride; first += stride) {
+        const auto stride_count = count(first, first + stride, isa);
+        if (stride_count > index) {
+            break;
+        }
+        index -= stride_count;
+    }
+    for (; first != last; ++first) {
+        if (detail::is_lead(*first)) {
+            if (index == 0) {
+                return first;
+            }
+            index -= 1;
+        }
+    }
+    return last;
+}
+
+// Counts the code points that start in the count elements at position.
+template<typename Segmented>
+std::ptrdiff_t count(const Segmented& segmented, std::ptrdiff_t position, std::ptrdiff_t count_, Isa isa = supported_isa()) {
+    std::ptrdiff_t code_point_count = 0;
+    segmented::for_each_segment(segmented, position, count_, [&code_point_count, isa](const char* first, const char* last) {
+        code_point_count += count(first, last, isa);
+    });
+    return code_point_count;
+}
+
+// Returns the position of the first sequence that is not valid UTF-8, or the
+// size of the content. A sequence that the gap splits is decoded from a
+// window made of its bytes on both sides of the gap.
+template<typename Segmented>
+std::ptrdiff_t find_invalid(const Segmented& segmented, Isa isa = supported_isa()) {
+    const auto segments = segmented::segments_of(segmented);
+    const auto& before_gap = segments.before_gap;
+    const auto& after_gap = segments.after_gap;
+    auto after_gap_first = after_gap.begin();
+    const auto found = find_invalid(before_gap.begin(), before_gap.end(), isa);
+    if (found != before_gap.end()) {
+        if (detail::sequence_length(found, before_gap.end()) == 0) {
+            return found - before_gap.begin();
+        }
+        const auto before_gap_count = before_gap.end() - found;
+        const auto after_gap_count = std::min<std::ptrdiff_t>(4 - before_gap_count, after_gap.size());
+        char window[4];
+        std::copy(after_gap.begin(), after_gap.begin() + after_gap_count, std::copy(found, before_gap.end(), window));
+        const auto length = detail::sequence_length(window, window + before_gap_count + after_gap_count);
+        if (length <= 0) {
+            return found - before_gap.begin();
+        }
+        after_gap_first += length - before_gap_count;
+    }
+    return before_gap.size() + (find_invalid(after_gap_first, after_gap.end(), isa) - after_gap.begin());
+}
+
+template<typename Segmented>
+bool is_valid(const Segmented& segmented, Isa isa = supported_isa()) {
+    return find_invalid(segmented, isa) == segmented::size(segmented);
+}
+
+// Returns the position of the start of the code point index code points
+// after the one that starts at position, or the size of the content.
+template<typename Segmented>
+std::ptrdiff_t find_code_point(const Segmented& segmented, std::ptrdiff_t position, std::ptrdiff_t index,
+    Isa isa = supported_isa()) {
+    const auto segments = segmented::segments_of(segmented);
+    const auto& before_gap = segments.before_gap;
+    const auto& after_gap = segments.after_gap;
+    if (position < before_gap.size()) {
+        const auto first = before_gap.begin() + position;
+        const auto found = find_code_point(first, before_gap.end(), index, isa);
+        if (found != before_gap.end()) {
+            return found - before_gap.begin();
+        }
+        index -= count(first, before_gap.end(), isa);
+        position = before_gap.size();
+    }
+    const auto after_gap_first = after_gap.begin() + (position - before_gap.size());
+    return before_gap.size() + (find_code_point(after_gap_first, after_gap.end(), index, isa) - after_gap.begin());
+}
+
+// Visits the code points of a range of UTF-8 bytes, such as the elements of
+// a GapBuffer<char>, as char32_t values. A code point is a lead byte and the
+// continuation bytes after it, which is how count and CodePointIndex count
+// them, and sequences that are not valid UTF-8 read as the replacement
+// character.
+template<typename ByteIterator>
+class CodePointIterator
+    : public boost::iterator_facade<CodePointIterator<ByteIterator>, char32_t, boost::bidirectional_traversal_tag, char32_t> {
+public:
+    CodePointIterator() {}
+
+    CodePointIterator(ByteIterator element_, ByteIterator first_, ByteIterator last_)
+        : element{element_}, first{first_}, last{last_} {}
+
+    ByteIterator base() const { return element; }
+
+private:
+    friend class boost::iterator_core_access;
+
+    bool equal(const CodePointIterator& other) const {
+        return element == other.element;
+    }
+
+    char32_t dereference() const {
+        return detail::decode(element, last);
+    }
+
+    void increment() {
+        do {
+            ++element;
+        } while ((element != last) && !detail::is_lead(*element));
+    }
+
+    void decrement() {
+        do {
+            --element;
+        } while ((element != first) && !detail::is_lead(*element));
+    }
+
+    ByteIterator element;
+    ByteIterator first;
+    ByteIterator last;
+};
+
+template<typename ByteRange>
+auto make_code_point_range(const ByteRange& byte_range) {
+    using ByteIterator = decltype(byte_range.begin());
+    const auto first = byte_range.begin();
+    const auto last = byte_range.end();
+    return make_range(CodePointIterator<ByteIterator>(first, first, last), CodePointIterator<ByteIterator>(last, first, last));
+}
+
+}
+}